@@ -10,11 +10,25 @@ void main() {
 #version 330 core
 
 uniform sampler2D tex0;
+// Index textures store a palette index in the red channel, looked up in this 256x1 texture
+uniform sampler2D palette;
+uniform bool paletted;
+// Set for textures whose pixels are either opaque or transparent. Transparent pixels are
+// thrown away so they do not hide what is behind them in the depth buffer
+uniform bool alphaTest;
 
 in vec2 tc;
 
 out vec4 fs_color;
 
 void main() {
-    fs_color = texture(tex0, tc);
+    if (paletted) {
+        int index = int(texture(tex0, tc).r * 255.0 + 0.5);
+        fs_color = texelFetch(palette, ivec2(index, 0), 0);
+    } else {
+        fs_color = texture(tex0, tc);
+    }
+    if (alphaTest && fs_color.a < 0.5) {
+        discard;
+    }
 }
\ No newline at end of file
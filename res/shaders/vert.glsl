@@ -1,14 +1,24 @@
 #version 330 core
 
-layout (location = 0) in vec4 pos;
+// Fixed point co-ordinates, see meshRegistry.hpp
+layout (location = 0) in vec2 pos;
 layout (location = 1) in vec2 tc_in;
 
-uniform mat4 transform;
+const float POSITION_STEP = 1.0 / 1024.0;
+const float UV_STEP = 1.0 / 2048.0;
+
+// One transformation per instance, so runs of draws that share everything else are drawn
+// with one call. Must match DRAW_BATCH_SIZE in renderSnapshot.hpp
+uniform mat4 transform[32];
+// How far the scene has scrolled, and how many texture repeats this shape moves per unit of it
+uniform float scroll;
+uniform float uvParallax;
 
 out vec2 tc;
 
 void main() {
-    tc = tc_in;
+    // Repeating textures wrap around, so scrolling is just an offset
+    tc = tc_in * UV_STEP + vec2(scroll * uvParallax, 0.0);
 
-    gl_Position = transform * pos;
+    gl_Position = transform[gl_InstanceID] * vec4(pos * POSITION_STEP, 0.0, 1.0);
 }
\ No newline at end of file
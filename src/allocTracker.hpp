@@ -0,0 +1,208 @@
+/**
+ * File contains the allocation tracker, which counts every heap allocation the program
+ * makes and which part of the program made it. Only built in when ASS1_TRACK_ALLOCATIONS
+ * is defined (the ass1_alloccheck target), otherwise ALLOC_SCOPE does nothing
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+/**
+ * The parts of the program allocations are counted against. Set for a block of code with ALLOC_SCOPE
+ */
+enum allocTag {
+    ALLOC_UNTAGGED,
+    ALLOC_INPUT,
+    ALLOC_TICK,
+    ALLOC_SNAPSHOT,
+    ALLOC_EVENTS,
+    ALLOC_RENDER,
+    ALLOC_PRESENT,
+    ALLOC_TOTAL_TAGS
+};
+
+const char *ALLOC_TAG_NAMES[ALLOC_TOTAL_TAGS] = {
+    "Untagged",
+    "Input",
+    "Simulation tick",
+    "Snapshot fill",
+    "Window events",
+    "Draw submission",
+    "Present",
+};
+
+/**
+ * Counts of allocations made against each tag. Subtract two of them to get what was
+ * allocated in between
+ */
+struct allocCounts {
+    long long allocations[ALLOC_TOTAL_TAGS] = {};
+    long long bytes[ALLOC_TOTAL_TAGS] = {};
+
+    allocCounts operator-(const allocCounts &other) const {
+        allocCounts difference;
+        for (int i = 0; i < ALLOC_TOTAL_TAGS; i++) {
+            difference.allocations[i] = allocations[i] - other.allocations[i];
+            difference.bytes[i] = bytes[i] - other.bytes[i];
+        }
+        return difference;
+    }
+
+    long long totalAllocations() const {
+        long long total = 0;
+        for (long long count : allocations) total += count;
+        return total;
+    }
+
+    /**
+     * Prints the allocations and bytes of every tag that allocated anything
+     */
+    void printReport() const {
+        std::cout << std::left << std::setw(24) << "  Tag" << std::right
+                  << std::setw(14) << "Allocations" << std::setw(14) << "Bytes" << "\n";
+        for (int i = 0; i < ALLOC_TOTAL_TAGS; i++) {
+            if (allocations[i] == 0) continue;
+            std::cout << std::left << std::setw(24) << (std::string("  ") + ALLOC_TAG_NAMES[i]) << std::right
+                      << std::setw(14) << allocations[i] << std::setw(14) << bytes[i] << "\n";
+        }
+    }
+};
+
+#ifdef ASS1_TRACK_ALLOCATIONS
+
+const bool ALLOC_TRACKING = true;
+
+std::atomic<long long> allocationCount[ALLOC_TOTAL_TAGS];
+std::atomic<long long> allocationBytes[ALLOC_TOTAL_TAGS];
+// What the current thread's allocations are counted against
+thread_local allocTag currentAllocTag = ALLOC_UNTAGGED;
+
+/**
+ * Counts an allocation against the current thread's tag
+ */
+void countAllocation(size_t size) {
+    allocationCount[currentAllocTag].fetch_add(1, std::memory_order_relaxed);
+    allocationBytes[currentAllocTag].fetch_add(size, std::memory_order_relaxed);
+}
+
+#ifdef ASS1_WRAP_MALLOC
+// The linker sends every call to malloc, calloc and realloc here (-Wl,--wrap), including
+// the ones in stb and chicken3421, and the __real_ functions to the C library
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    countAllocation(size);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    countAllocation(count * size);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    countAllocation(size);
+    return __real_realloc(ptr, size);
+}
+}
+#endif
+
+/**
+ * malloc and free for operator new and delete, counted against the current thread's tag
+ */
+void *trackedMalloc(size_t size) {
+#ifndef ASS1_WRAP_MALLOC
+    // Otherwise malloc counts it itself
+    countAllocation(size);
+#endif
+    return std::malloc(size);
+}
+
+void trackedFree(void *ptr) {
+    std::free(ptr);
+}
+
+/**
+ * Reads how much has been allocated so far
+ */
+allocCounts readAllocCounts() {
+    allocCounts counts;
+    for (int i = 0; i < ALLOC_TOTAL_TAGS; i++) {
+        counts.allocations[i] = allocationCount[i].load(std::memory_order_relaxed);
+        counts.bytes[i] = allocationBytes[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+/**
+ * Counts everything allocated on this thread until the end of the scope against a tag
+ */
+struct allocScope {
+    allocTag previous;
+
+    allocScope(allocTag tag) : previous(currentAllocTag) {
+        currentAllocTag = tag;
+    }
+
+    ~allocScope() {
+        currentAllocTag = previous;
+    }
+};
+
+#define ALLOC_CONCAT_INNER(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_INNER(a, b)
+#define ALLOC_SCOPE(tag) allocScope ALLOC_CONCAT(allocScope_, __LINE__)(tag)
+
+// Replaces the global allocation functions so every new and delete is counted
+void *operator new(size_t size) {
+    void *ptr = trackedMalloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return trackedMalloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return trackedMalloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void *ptr) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    trackedFree(ptr);
+}
+
+#else
+
+const bool ALLOC_TRACKING = false;
+
+allocCounts readAllocCounts() {
+    return allocCounts();
+}
+
+#define ALLOC_SCOPE(tag)
+
+#endif
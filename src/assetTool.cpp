@@ -0,0 +1,126 @@
+/**
+ * Offline asset tool. Converts the resources into the formats the program loads fastest
+ *
+ * Usage:
+ *   ass1_assettool palettise <png files or folders...>
+ *       Writes a .ipal file next to every image that has 256 colours or less
+ *   ass1_assettool flipbook <output.flip> <png files...>
+ *       Writes the given frames, in the order they play, as a single flipbook
+ */
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stb/stb_image.h>
+#include <chicken3421/chicken3421.hpp>
+
+#include "palettisedImage.hpp"
+#include "flipbook.hpp"
+
+/**
+ * Collects every PNG in the given paths, looking through folders recursively
+ */
+std::vector<std::string> collectImages(int argc, char **argv, int firstArg) {
+    std::vector<std::string> images;
+    for (int i = firstArg; i < argc; i++) {
+        std::filesystem::path path(argv[i]);
+        if (std::filesystem::is_directory(path)) {
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(path)) {
+                if (entry.path().extension() == ".png") images.push_back(entry.path().generic_string());
+            }
+        } else {
+            images.push_back(path.generic_string());
+        }
+    }
+    return images;
+}
+
+/**
+ * Palettises every given image that fits in 256 colours
+ */
+int palettiseAssets(const std::vector<std::string> &images) {
+    int converted = 0;
+    for (const std::string &fileName : images) {
+        chicken3421::image_t img = chicken3421::load_image(fileName);
+        palettisedImage indexedImg;
+        if (palettiseImage((unsigned char *)img.data, img.width, img.height, img.n_channels, indexedImg)) {
+            if (!writePalettisedImage(palettisedPath(fileName), indexedImg)) {
+                std::cerr << "Could not write " << palettisedPath(fileName) << "\n";
+                chicken3421::delete_image(img);
+                return EXIT_FAILURE;
+            }
+            std::cout << fileName << ": " << indexedImg.paletteSize << " colours, "
+                      << (long long)img.width * img.height * 4 / 1024 << " KiB -> "
+                      << (indexedImg.indices.size() + MAX_PALETTE_SIZE * 4) / 1024 << " KiB\n";
+            converted++;
+        } else {
+            std::cout << fileName << ": more than " << MAX_PALETTE_SIZE << " colours, left as is\n";
+        }
+        chicken3421::delete_image(img);
+    }
+    std::cout << converted << " of " << images.size() << " images palettised\n";
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Stores the given frames as one keyframe and the pixels that change in each frame after it
+ */
+int flipbookAssets(const std::string &outputName, const std::vector<std::string> &images) {
+    std::vector<chicken3421::image_t> frames;
+    std::vector<const unsigned char *> framePixels;
+    for (const std::string &fileName : images) {
+        frames.push_back(chicken3421::load_image(fileName));
+        framePixels.push_back((unsigned char *)frames.back().data);
+        if (frames.back().width != frames[0].width || frames.back().height != frames[0].height || frames.back().n_channels != frames[0].n_channels) {
+            std::cerr << fileName << ": frames must all be the same size and format\n";
+            for (chicken3421::image_t &frame : frames) chicken3421::delete_image(frame);
+            return EXIT_FAILURE;
+        }
+    }
+
+    flipbook book;
+    makeFlipbook(framePixels, frames[0].width, frames[0].height, frames[0].n_channels, book);
+    for (chicken3421::image_t &frame : frames) chicken3421::delete_image(frame);
+
+    for (size_t i = 0; i < book.frames.size(); i++) {
+        const dirtyRect &rect = book.frames[i].rect;
+        std::cout << images[i] << ": ";
+        if (rect.width == 0) {
+            std::cout << "same as the previous frame\n";
+        } else {
+            std::cout << rect.width << "x" << rect.height << " changed at (" << rect.x << ", " << rect.y << "), "
+                      << book.frames[i].pixels.size() / 1024 << " KiB\n";
+        }
+    }
+    if (!writeFlipbook(outputName, book)) {
+        std::cerr << "Could not write " << outputName << "\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << book.frames.size() << " frames, " << (long long)book.width * book.height * 4 * book.frames.size() / 1024
+              << " KiB -> " << (book.keyframe.size() + book.changedBytes()) / 1024 << " KiB\n";
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " palettise <png files or folders...>\n"
+                  << "       " << argv[0] << " flipbook <output.flip> <png files...>\n";
+        return EXIT_FAILURE;
+    }
+
+    // Images are stored flipped, the same way the program loads them
+    stbi_set_flip_vertically_on_load(true);
+
+    std::string command = argv[1];
+    if (command == "palettise") {
+        return palettiseAssets(collectImages(argc, argv, 2));
+    }
+    if (command == "flipbook" && argc >= 4) {
+        return flipbookAssets(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+    }
+
+    std::cerr << "Unknown command: " << command << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,213 @@
+/**
+ * Microbenchmarks for the hot paths of the program. Run from the same folder as the
+ * application so the resources can be found. Results are printed as JSON, and also
+ * written to the file given as the first argument
+ *
+ * Usage: ass1_bench [output.json] [--state <file.state>]
+ *   --state  also times whole ticks starting from a scene saved with --save-state
+ */
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#include <cstdlib>
+#include <chrono>
+#include <filesystem>
+#include <list>
+#include <sstream>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <iostream>
+
+#include "programSettings.hpp"
+#include "memoryTracker.hpp"
+#include "startupProfiler.hpp"
+#include "palettisedImage.hpp"
+#include "flipbook.hpp"
+#include "helperFunctions.hpp"
+#include "vert.hpp"
+#include "meshRegistry.hpp"
+#include "shapeObject.hpp"
+#include "goatObject.hpp"
+#include "snowFlakeObject.hpp"
+#include "mainMenuScene.hpp"
+#include "inputQueue.hpp"
+#include "renderSnapshot.hpp"
+#include "bitmapFont.hpp"
+#include "timerWheel.hpp"
+#include "textureResidency.hpp"
+#include "sceneryChunks.hpp"
+#include "scene.hpp"
+#include "sceneState.hpp"
+#include "shapeCreation.hpp"
+#include "benchHarness.hpp"
+
+// Most ticks a batch of snowflake ticks can run before the flakes are set up again.
+// Short enough that flakes spread over the screen do not fall or scroll off it
+const long FLAKE_BATCH_TICKS = 16;
+
+/**
+ * Makes the first flakeCount snowflakes active with a full life time, and the rest inactive.
+ * Active flakes are spread over the screen away from its bottom and left edges, so none of
+ * them are culled or sent back to the pool within FLAKE_BATCH_TICKS
+ */
+void activateFlakes(scene<appConfig> &sceneObjects, int flakeCount) {
+    sceneObjects.flakeBudget = flakeCount;
+    for (int i = 0; i < appConfig::FLAKE_TOTAL; i++) {
+        sceneObjects.snowFlakes[i].isActive = i < flakeCount;
+        sceneObjects.snowFlakes[i].flakeLifeTime = appConfig::FLAKE_TIMER;
+        if (i < flakeCount) {
+            shapeObject &flakeShape = sceneObjects.snowFlakes[i].snowFlakeShape;
+            float x = 1.6f * std::fmod(i * 0.618034f, 1.0f) - 0.6f;
+            float y = 1.6f * (i + 0.5f) / flakeCount - 0.6f;
+            flakeShape.resetTransforms();
+            flakeShape.scale = glm::scale(flakeShape.scale, glm::vec3(appConfig::FLAKE_SCALE, appConfig::FLAKE_SCALE, 0.0));
+            flakeShape.trans = glm::translate(flakeShape.trans, glm::vec3(x, y, 0.0));
+            sceneObjects.timers.schedule(TIMER_FIRST_FLAKE + i, appConfig::FLAKE_TIMER);
+        } else {
+            sceneObjects.timers.cancel(TIMER_FIRST_FLAKE + i);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string outputPath, statePath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--state") {
+            statePath = argv[++i];
+        } else {
+            outputPath = arg;
+        }
+    }
+
+    // A hidden window is still needed for the textures and buffers the scene creates
+    GLFWwindow *win = chicken3421::make_opengl_window(appConfig::SCREEN_WIDTH, appConfig::SCREEN_HEIGHT, appConfig::APP_TITLE);
+    glfwHideWindow(win);
+    stbi_set_flip_vertically_on_load(true);
+
+    seedRdm(3421);
+    scene<appConfig> sceneObjects;
+    GLuint flakeTex = makeTexture("res/img/snowFlakeATexture.png");
+    for (int i = 0; i < appConfig::FLAKE_TOTAL; i++) {
+        sceneObjects.snowFlakes[i] = createSnowFlake<appConfig>();
+        sceneObjects.snowFlakes[i].snowFlakeShape.textureID = flakeTex;
+    }
+    goatObject<appConfig> goatObj = createGoat<appConfig>();
+    sceneObjects.goat = goatObj;
+
+    benchHarness harness;
+
+    // Snowflakes at several counts, up to every flake being alive
+    const int flakeCounts[] = {appConfig::FLAKE_TOTAL / 8, appConfig::FLAKE_TOTAL / 2, appConfig::FLAKE_TOTAL};
+    for (int flakeCount : flakeCounts) {
+        harness.run("scene::tickSnowFlake/" + std::to_string(flakeCount), [&] {
+            sceneObjects.tickSnowFlake(true);
+        }, [&] {
+            activateFlakes(sceneObjects, flakeCount);
+        }, FLAKE_BATCH_TICKS);
+    }
+
+    harness.run("scene::windInfluence", [&] {
+        benchSink = benchSink + sceneObjects.windInfluence(true);
+    });
+
+    // Scrolls the props as well. Chunks asked for in the last batch are laid out and uploaded
+    // before the next, so the pool keeps being recycled without timing the upload. Nothing is
+    // drawn, so every chunk retired so far counts as presented
+    harness.run("scene::tickGround", [&] {
+        sceneObjects.tickGround();
+    }, [&] {
+        sceneObjects.chunks.finishGenerating();
+        sceneObjects.chunks.update(sceneObjects.chunks.epoch());
+    });
+
+    for (int flakeCount : flakeCounts) {
+        harness.run("scene::getAllObjects/" + std::to_string(flakeCount), [&] {
+            std::list<shapeObject> shapeList = sceneObjects.getAllObjects();
+            benchSink = benchSink + shapeList.size();
+        }, [&] {
+            activateFlakes(sceneObjects, flakeCount);
+        });
+    }
+
+    // What the simulation thread publishes to the render loop every tick
+    renderSnapshot snapshot;
+    for (int flakeCount : flakeCounts) {
+        harness.run("scene::fillSnapshot/" + std::to_string(flakeCount), [&] {
+            sceneObjects.fillSnapshot(snapshot);
+            benchSink = benchSink + snapshot.draws.size();
+        }, [&] {
+            activateFlakes(sceneObjects, flakeCount);
+        });
+    }
+
+    if (!statePath.empty()) {
+        // Whole ticks from a saved scene. The state is kept in memory and restored before
+        // every batch so each one starts from exactly the same point
+        std::ifstream stateFile(statePath, std::ios::binary);
+        std::stringstream stateBuffer;
+        stateBuffer << stateFile.rdbuf();
+        bool stateGameState = false;
+        chicken3421::expect(loadSceneState(stateBuffer, sceneObjects, stateGameState), "Could not load scene state " + statePath);
+        harness.run("scene::tickAll/state", [&] {
+            sceneObjects.tickAll(stateGameState);
+        }, [&] {
+            stateBuffer.clear();
+            stateBuffer.seekg(0);
+            loadSceneState(stateBuffer, sceneObjects, stateGameState);
+            // Loading asks for chunks and textures again, which must not be worked on during the batch
+            sceneObjects.chunks.finishGenerating();
+            sceneObjects.sceneryTextures.finishDecoding();
+        });
+    }
+
+    // The model matrix composed for every draw call
+    shapeObject &flakeShape = sceneObjects.snowFlakes[0].snowFlakeShape;
+    harness.run("transform/trans*rot*scale", [&] {
+        glm::mat4 model = flakeShape.trans * flakeShape.rot * flakeShape.scale;
+        benchSink = benchSink + model[3][0];
+    });
+
+    harness.run("goatObject::nextFrame", [&] {
+        sceneObjects.goat.nextFrame();
+    });
+
+    harness.run("rdmNumGen", [&] {
+        benchSink = benchSink + rdmNumGen();
+    });
+
+    // Decodes every image in the resources folder. The decoded image is freed straight
+    // away instead of waiting for deleteAllTexImg
+    std::vector<std::string> assets;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator("res/img")) {
+        if (entry.path().extension() == ".png") assets.push_back(entry.path().generic_string());
+    }
+    std::sort(assets.begin(), assets.end());
+    for (const std::string &asset : assets) {
+        harness.runFixed("makeImage/" + asset, 5, [&] {
+            makeImage(asset);
+            chicken3421::delete_image(listOfEveryImage.back());
+            listOfEveryImage.pop_back();
+        });
+    }
+
+    harness.writeJson(std::cout);
+    if (!outputPath.empty()) {
+        std::ofstream outFile(outputPath);
+        harness.writeJson(outFile);
+    }
+
+    sceneObjects.deleteAllShapes();
+    meshes.deleteAll();
+    deleteAllTexImg();
+    glfwDestroyWindow(win);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/**
+ * File contains a small microbenchmark harness. Each benchmark is run in batches
+ * until enough time has passed, and the results are written out as JSON
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Stores values produced by benchmarks so the compiler cannot optimise the work away
+volatile double benchSink = 0;
+
+/**
+ * Contains the timings of one benchmark. All times are in nanoseconds per operation
+ */
+struct benchResult {
+    std::string name;
+    long iterations;
+    double meanNs;
+    double medianNs;
+    double minNs;
+    double maxNs;
+};
+
+/**
+ * Runs benchmarks and collects their results
+ */
+struct benchHarness {
+    std::vector<benchResult> results;
+    int samples = 15;         // How many batches are timed per benchmark
+    double minSampleMs = 20;  // Minimum length of a single batch
+
+    /**
+     * Times a function. The batch size is grown until one batch takes at least
+     * minSampleMs, then that many batches are timed
+     * @param name name of the benchmark in the output
+     * @param fn the operation being measured
+     * @param setup run before every batch, outside of the timed region
+     * @param maxBatchSize largest a batch can grow to, for operations that drift away from
+     * what setup left them with the longer they run
+     */
+    void run(const std::string &name, const std::function<void()> &fn, const std::function<void()> &setup = [] {}, long maxBatchSize = 1L << 30) {
+        using namespace std::chrono;
+
+        // Works out how many operations fit in one batch
+        long batchSize = 1;
+        while (true) {
+            setup();
+            steady_clock::time_point start = steady_clock::now();
+            for (long i = 0; i < batchSize; i++) fn();
+            double elapsedMs = duration<double, std::milli>(steady_clock::now() - start).count();
+            if (elapsedMs >= minSampleMs || batchSize >= maxBatchSize) break;
+            batchSize *= 2;
+        }
+
+        std::vector<double> perOpNs;
+        for (int s = 0; s < samples; s++) {
+            setup();
+            steady_clock::time_point start = steady_clock::now();
+            for (long i = 0; i < batchSize; i++) fn();
+            double elapsedNs = duration<double, std::nano>(steady_clock::now() - start).count();
+            perOpNs.push_back(elapsedNs / batchSize);
+        }
+        record(name, batchSize * samples, perOpNs);
+    }
+
+    /**
+     * Times a function a fixed amount of times. Used for slow operations such as
+     * decoding images, where growing the batch would take too long
+     */
+    void runFixed(const std::string &name, int iterations, const std::function<void()> &fn) {
+        using namespace std::chrono;
+        std::vector<double> perOpNs;
+        for (int i = 0; i < iterations; i++) {
+            steady_clock::time_point start = steady_clock::now();
+            fn();
+            perOpNs.push_back(duration<double, std::nano>(steady_clock::now() - start).count());
+        }
+        record(name, iterations, perOpNs);
+    }
+
+    /**
+     * Writes all results as JSON into the given stream
+     */
+    void writeJson(std::ostream &out) {
+        out << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            benchResult &r = results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                << ", \"time_unit\": \"ns\", \"mean\": " << r.meanNs << ", \"median\": " << r.medianNs
+                << ", \"min\": " << r.minNs << ", \"max\": " << r.maxNs << "}";
+            out << ((i + 1 < results.size()) ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+
+private:
+    /**
+     * Summarises the per operation timings of a benchmark and stores them
+     */
+    void record(const std::string &name, long iterations, std::vector<double> &perOpNs) {
+        std::sort(perOpNs.begin(), perOpNs.end());
+        double total = 0;
+        for (double ns : perOpNs) total += ns;
+
+        benchResult r;
+        r.name = name;
+        r.iterations = iterations;
+        r.meanNs = total / perOpNs.size();
+        r.medianNs = perOpNs[perOpNs.size() / 2];
+        r.minNs = perOpNs.front();
+        r.maxNs = perOpNs.back();
+        results.push_back(r);
+
+        std::cerr << name << ": " << r.medianNs << " ns/op\n";
+    }
+};
@@ -0,0 +1,297 @@
+/**
+ * File contains the bitmap font every piece of text is drawn with. The glyphs are kept
+ * in the code and drawn into a single atlas texture at startup, once per text style.
+ * Text is laid out into quads that sample the atlas, either into a shape of its own
+ * (the splash text) or into a textBatch that is filled and drawn in one call every frame
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Printable ASCII, from space to tilde. Anything else is drawn as '?'
+const int FONT_FIRST_CHAR = 32;
+const int FONT_GLYPHS = 95;
+// Each glyph is 5x7 pixels. Its cell in the atlas is one pixel wider and taller to make
+// room for the drop shadow, and text advances by the width of a cell
+const int GLYPH_WIDTH = 5;
+const int GLYPH_HEIGHT = 7;
+const int GLYPH_ADVANCE = GLYPH_WIDTH + 1;
+const int GLYPH_LINE_HEIGHT = GLYPH_HEIGHT + 2;
+// The atlas is a grid of 8x8 cells, 16 to a row. A power of two in size so the edges of
+// the cells land exactly on packed texture co-ordinates
+const int ATLAS_CELL = 8;
+const int ATLAS_COLUMNS = 16;
+const int ATLAS_ROWS_PER_STYLE = (FONT_GLYPHS + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+const int ATLAS_SIZE = 128;
+
+/**
+ * Each glyph as 5 columns from left to right. Bit 0 of a column is its top pixel
+ */
+const uint8_t FONT_COLUMNS[FONT_GLYPHS][GLYPH_WIDTH] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00}, // ' ' ! "
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62}, // # $ %
+    {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00}, // & ' (
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x08, 0x2A, 0x1C, 0x2A, 0x08}, {0x08, 0x08, 0x3E, 0x08, 0x08}, // ) * +
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00}, // , - .
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00}, // / 0 1
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31}, {0x18, 0x14, 0x12, 0x7F, 0x10}, // 2 3 4
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03}, // 5 6 7
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00}, // 8 9 :
+    {0x00, 0x56, 0x36, 0x00, 0x00}, {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14}, // ; < =
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06}, {0x32, 0x49, 0x79, 0x41, 0x3E}, // > ? @
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22}, // A B C
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01}, // D E F
+    {0x3E, 0x41, 0x49, 0x49, 0x7A}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00}, // G H I
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40}, // J K L
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E}, // M N O
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46}, // P Q R
+    {0x46, 0x49, 0x49, 0x49, 0x31}, {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F}, // S T U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63}, // V W X
+    {0x07, 0x08, 0x70, 0x08, 0x07}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x00}, // Y Z [
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7F, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04}, // \ ] ^
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78}, // _ ` a
+    {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20}, {0x38, 0x44, 0x44, 0x48, 0x7F}, // b c d
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x0C, 0x52, 0x52, 0x52, 0x3E}, // e f g
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00}, // h i j
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78}, // k l m
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0x7C, 0x14, 0x14, 0x14, 0x08}, // n o p
+    {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20}, // q r s
+    {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C}, // t u v
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C}, // w x y
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x7F, 0x00, 0x00}, // z { |
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x08, 0x04, 0x08, 0x10, 0x08},                                 // } ~
+};
+
+/**
+ * The colours text can be drawn in. Each one has its own copy of the glyphs in the atlas
+ */
+enum textStyle {
+    TEXT_SPLASH,  // Yellow, like the splash text on Minecraft's title screen
+    TEXT_HUD,     // White
+    TEXT_STYLES
+};
+
+// Colour of the glyph and of its shadow in each style (RGBA)
+const unsigned char TEXT_STYLE_COLOURS[TEXT_STYLES][2][4] = {
+    {{255, 255, 0, 255}, {63, 63, 0, 255}},
+    {{255, 255, 255, 255}, {63, 63, 63, 255}},
+};
+
+// The atlas every piece of text samples. Made by makeFontAtlas
+GLuint fontAtlas = 0;
+
+/**
+ * Draws every glyph in every style into a texture, with its shadow one pixel below and
+ * to the right. Pixels are either opaque or transparent, so text is drawn as a cutout
+ * @return GLuint texture handler
+ */
+GLuint makeFontAtlas() {
+    static_assert(ATLAS_COLUMNS * ATLAS_CELL <= ATLAS_SIZE && TEXT_STYLES * ATLAS_ROWS_PER_STYLE * ATLAS_CELL <= ATLAS_SIZE,
+                  "Font atlas too small");
+    std::vector<unsigned char> pixels(ATLAS_SIZE * ATLAS_SIZE * 4, 0);
+    auto setPixel = [&](int x, int y, const unsigned char *colour) {
+        memcpy(&pixels[((size_t)y * ATLAS_SIZE + x) * 4], colour, 4);
+    };
+
+    for (int style = 0; style < TEXT_STYLES; style++) {
+        for (int glyph = 0; glyph < FONT_GLYPHS; glyph++) {
+            // Textures are flipped on load, so row 0 of the atlas is its bottom
+            int cellX = (glyph % ATLAS_COLUMNS) * ATLAS_CELL;
+            int cellTop = (style * ATLAS_ROWS_PER_STYLE + glyph / ATLAS_COLUMNS) * ATLAS_CELL + GLYPH_HEIGHT;
+            // The shadow goes down first so the glyph covers it where they overlap
+            for (int layer = 1; layer >= 0; layer--) {
+                for (int column = 0; column < GLYPH_WIDTH; column++) {
+                    for (int row = 0; row < GLYPH_HEIGHT; row++) {
+                        if (!(FONT_COLUMNS[glyph][column] >> row & 1)) continue;
+                        setPixel(cellX + column + layer, cellTop - row - layer, TEXT_STYLE_COLOURS[style][layer]);
+                    }
+                }
+            }
+        }
+    }
+
+    GLuint atlas = uploadTexture(GL_RGBA8, GL_RGBA, ATLAS_SIZE, ATLAS_SIZE, pixels.data());
+    memTracker.trackTexture(atlas, MEM_OTHER_TEXTURES, ATLAS_SIZE, ATLAS_SIZE, 4);
+    alphaOfTexture[atlas] = ALPHA_BINARY;
+    return atlas;
+}
+
+/**
+ * How wide the widest line of some text is, in font pixels
+ */
+int textWidth(const char *text) {
+    int widest = 0, chars = 0;
+    for (const char *c = text; ; c++) {
+        if (*c == '\n' || *c == '\0') {
+            widest = std::max(widest, chars * GLYPH_ADVANCE);
+            chars = 0;
+            if (*c == '\0') break;
+        } else {
+            chars++;
+        }
+    }
+    return widest;
+}
+
+/**
+ * How tall some text is, in font pixels
+ */
+int textHeight(const char *text) {
+    int lines = 1;
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == '\n') lines++;
+    }
+    return lines * GLYPH_LINE_HEIGHT - (GLYPH_LINE_HEIGHT - GLYPH_HEIGHT - 1);
+}
+
+/**
+ * How many quads some text is laid out into. Spaces and line breaks have none
+ */
+int textGlyphCount(const char *text) {
+    int glyphs = 0;
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c != ' ' && *c != '\n') glyphs++;
+    }
+    return glyphs;
+}
+
+/**
+ * Lays out text as two triangles per glyph. Lines are split on '\n'
+ * @param topLeft where the top left corner of the first line goes
+ * @param pixelSize how big a pixel of the font is
+ * @param centred whether each line is centred on topLeft.x instead of starting there
+ * @param out the vertices are added to the end of this
+ */
+void layoutText(const char *text, textStyle style, glm::vec2 topLeft, float pixelSize, bool centred, std::vector<vert> &out) {
+    const float CELL_UV = (float)ATLAS_CELL / ATLAS_SIZE;
+    const float GLYPH_U = (float)GLYPH_ADVANCE / ATLAS_SIZE;
+    const float GLYPH_V = (float)(GLYPH_HEIGHT + 1) / ATLAS_SIZE;
+    float glyphWidth = GLYPH_ADVANCE * pixelSize, glyphHeight = (GLYPH_HEIGHT + 1) * pixelSize;
+
+    glm::vec2 pen = topLeft;
+    const char *lineStart = text;
+    for (const char *c = text; ; c++) {
+        if (c == lineStart && centred) {
+            // Measures up to the end of this line only
+            int chars = 0;
+            while (lineStart[chars] != '\n' && lineStart[chars] != '\0') chars++;
+            pen.x = topLeft.x - chars * glyphWidth / 2;
+        }
+        if (*c == '\0') break;
+        if (*c == '\n') {
+            pen = glm::vec2(topLeft.x, pen.y - GLYPH_LINE_HEIGHT * pixelSize);
+            lineStart = c + 1;
+            continue;
+        }
+        if (*c != ' ') {
+            int glyph = (*c >= FONT_FIRST_CHAR && *c < FONT_FIRST_CHAR + FONT_GLYPHS) ? *c - FONT_FIRST_CHAR : '?' - FONT_FIRST_CHAR;
+            float u = (glyph % ATLAS_COLUMNS) * CELL_UV;
+            float v = (style * ATLAS_ROWS_PER_STYLE + glyph / ATLAS_COLUMNS) * CELL_UV;
+            float left = pen.x, right = pen.x + glyphWidth, top = pen.y, bottom = pen.y - glyphHeight;
+            out.push_back({{right, top, 0, 1}, {u + GLYPH_U, v + GLYPH_V}});
+            out.push_back({{right, bottom, 0, 1}, {u + GLYPH_U, v}});
+            out.push_back({{left, bottom, 0, 1}, {u, v}});
+            out.push_back({{right, top, 0, 1}, {u + GLYPH_U, v + GLYPH_V}});
+            out.push_back({{left, bottom, 0, 1}, {u, v}});
+            out.push_back({{left, top, 0, 1}, {u, v + GLYPH_V}});
+        }
+        pen.x += glyphWidth;
+    }
+}
+
+/**
+ * Text that changes every frame, such as the HUD. Everything added between clear and draw
+ * ends up in one vertex buffer and is drawn in one call. Only used by the render thread
+ */
+struct textBatch {
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    int maxGlyphs = 0;
+    std::vector<vert> verts;
+    std::vector<packedVert> packed;
+
+    /**
+     * Creates the vertex buffer. Nothing is allocated after this
+     * @param glyphs the most glyphs the batch holds. Text that does not fit is left out
+     */
+    void setup(int glyphs) {
+        maxGlyphs = glyphs;
+        verts.reserve(6 * maxGlyphs);
+        packed.reserve(6 * maxGlyphs);
+
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, (GLintptr)(sizeof(packedVert) * 6 * maxGlyphs), nullptr, GL_DYNAMIC_DRAW);
+        memTracker.trackBuffer(vbo, MEM_SHAPE_BUFFERS, sizeof(packedVert) * 6 * maxGlyphs,
+                              (sizeof(vert) + sizeof(packedVert)) * 6 * maxGlyphs);
+
+        // The same layout as the meshes in meshRegistry, so the scene's program draws it as is
+        glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, sizeof(packedVert), (void *)offsetof(packedVert, x));
+        glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(packedVert), (void *)offsetof(packedVert, u));
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void clear() {
+        verts.clear();
+    }
+
+    /**
+     * Lays out a line of text, with topLeft in clip space
+     */
+    void add(const char *text, textStyle style, glm::vec2 topLeft, float pixelSize) {
+        if ((int)verts.size() / 6 + textGlyphCount(text) > maxGlyphs) return;
+        layoutText(text, style, topLeft, pixelSize, false, verts);
+    }
+
+    /**
+     * Uploads and draws everything added since the last clear over what is on screen.
+     * The scene's program must already be in use
+     */
+    void draw(const snapshotRenderer &renderer) {
+        if (verts.empty()) return;
+        packed.clear();
+        for (const vert &v : verts) {
+            packed.push_back(meshRegistry::pack(v));
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        // Orphans last frame's buffer so the driver does not wait for it to be drawn
+        glBufferData(GL_ARRAY_BUFFER, (GLintptr)(sizeof(packedVert) * 6 * maxGlyphs), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLintptr)(sizeof(packedVert) * packed.size()), packed.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glm::mat4 identity(1.0f);
+        glUniformMatrix4fv(renderer.transformLoc, 1, GL_FALSE, glm::value_ptr(identity));
+        glUniform1f(renderer.uvParallaxLoc, 0);
+        glUniform1i(renderer.alphaTestLoc, true);
+        glDisable(GL_BLEND);
+        bindTexture(fontAtlas, renderer.palettedLoc);
+        glBindVertexArray(vao);
+        glDrawArrays(GL_TRIANGLES, 0, packed.size());
+        glBindVertexArray(0);
+        glUniform1i(renderer.alphaTestLoc, false);
+        glEnable(GL_BLEND);
+    }
+
+    void deleteSelf() {
+        memTracker.untrackBuffer(vbo);
+        glDeleteBuffers(1, &vbo);
+        glDeleteVertexArrays(1, &vao);
+        vao = vbo = 0;
+    }
+};
@@ -0,0 +1,169 @@
+/**
+ * File contains flipbook, an animation stored as one keyframe and the rectangle of pixels
+ * that changed in each frame after it, along with functions to make one from separate
+ * frames and to read/write it in the .flip format. Does not depend on OpenGL so the asset
+ * tool can use it
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// .flip file layout: magic, version, width, height, frame count, the keyframe (RGBA), then
+// for every frame its dirtyRect followed by the rectangle's pixels (RGBA)
+const char FLIP_MAGIC[4] = {'F', 'L', 'I', 'P'};
+const uint32_t FLIP_VERSION = 1;
+
+/**
+ * The part of a frame that differs from the frame before it. Empty (0 width) when the
+ * two frames are the same
+ */
+struct dirtyRect {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+/**
+ * What has to be copied over the previous frame to get this one
+ */
+struct flipbookFrame {
+    dirtyRect rect;
+    std::vector<unsigned char> pixels; // rect.width * rect.height * 4 bytes of RGBA, row by row
+};
+
+/**
+ * Contains an animation as its first frame and the changes that make up every frame.
+ * Frame 0's change is from the last frame, so the animation can loop
+ */
+struct flipbook {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> keyframe; // width * height * 4 bytes of RGBA
+    std::vector<flipbookFrame> frames;
+    long long fileBytes = 0;             // Size of the .flip file it was read from, 0 if it was made in memory
+
+    /**
+     * Bytes of pixels stored for all the changes together
+     */
+    size_t changedBytes() const {
+        size_t bytes = 0;
+        for (const flipbookFrame &frame : frames) bytes += frame.pixels.size();
+        return bytes;
+    }
+};
+
+/**
+ * Finds the smallest rectangle holding every pixel that differs between two RGBA frames
+ */
+dirtyRect findDirtyRect(const unsigned char *before, const unsigned char *after, int width, int height) {
+    int minX = width, minY = height, maxX = -1, maxY = -1;
+    for (int y = 0; y < height; y++) {
+        const uint32_t *rowBefore = (const uint32_t *)(before + (size_t)y * width * 4);
+        const uint32_t *rowAfter = (const uint32_t *)(after + (size_t)y * width * 4);
+        for (int x = 0; x < width; x++) {
+            if (rowBefore[x] == rowAfter[x]) continue;
+            if (x < minX) minX = x;
+            if (x > maxX) maxX = x;
+            if (y < minY) minY = y;
+            maxY = y;
+        }
+    }
+
+    dirtyRect rect;
+    if (maxX >= 0) {
+        rect = {(uint32_t)minX, (uint32_t)minY, (uint32_t)(maxX - minX + 1), (uint32_t)(maxY - minY + 1)};
+    }
+    return rect;
+}
+
+/**
+ * Converts separate frames of the same size into a flipbook. Frames that are the same as
+ * the one before them store nothing
+ * @param frames pixels of each frame, row by row
+ * @param channels 3 for RGB, 4 for RGBA
+ */
+void makeFlipbook(const std::vector<const unsigned char *> &frames, int width, int height, int channels, flipbook &result) {
+    result.width = width;
+    result.height = height;
+    result.frames.clear();
+    if (frames.empty()) return;
+
+    // Every frame as RGBA, so frames can be compared a pixel at a time
+    size_t frameSize = (size_t)width * height * 4;
+    std::vector<std::vector<unsigned char>> rgbaFrames(frames.size(), std::vector<unsigned char>(frameSize));
+    for (size_t i = 0; i < frames.size(); i++) {
+        for (size_t pixel = 0; pixel < (size_t)width * height; pixel++) {
+            const unsigned char *source = frames[i] + pixel * channels;
+            unsigned char *dest = rgbaFrames[i].data() + pixel * 4;
+            dest[0] = source[0];
+            dest[1] = source[1];
+            dest[2] = source[2];
+            dest[3] = (channels == 4) ? source[3] : 255;
+        }
+    }
+    result.keyframe = rgbaFrames[0];
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        const std::vector<unsigned char> &before = rgbaFrames[(i + frames.size() - 1) % frames.size()];
+        const std::vector<unsigned char> &after = rgbaFrames[i];
+        flipbookFrame frame;
+        frame.rect = findDirtyRect(before.data(), after.data(), width, height);
+        for (uint32_t y = frame.rect.y; y < frame.rect.y + frame.rect.height; y++) {
+            const unsigned char *row = after.data() + ((size_t)y * width + frame.rect.x) * 4;
+            frame.pixels.insert(frame.pixels.end(), row, row + frame.rect.width * 4);
+        }
+        result.frames.push_back(std::move(frame));
+    }
+}
+
+/**
+ * Writes a flipbook into a .flip file
+ * @return bool whether the file was written
+ */
+bool writeFlipbook(const std::string &fileName, const flipbook &book) {
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file) return false;
+    uint32_t header[4] = {FLIP_VERSION, (uint32_t)book.width, (uint32_t)book.height, (uint32_t)book.frames.size()};
+    file.write(FLIP_MAGIC, sizeof(FLIP_MAGIC));
+    file.write((const char *)header, sizeof(header));
+    file.write((const char *)book.keyframe.data(), book.keyframe.size());
+    for (const flipbookFrame &frame : book.frames) {
+        file.write((const char *)&frame.rect, sizeof(frame.rect));
+        file.write((const char *)frame.pixels.data(), frame.pixels.size());
+    }
+    return (bool)file;
+}
+
+/**
+ * Reads a .flip file
+ * @return bool whether the file existed and was valid
+ */
+bool readFlipbook(const std::string &fileName, flipbook &book) {
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file) return false;
+
+    char magic[4];
+    uint32_t header[4];
+    file.read(magic, sizeof(magic));
+    file.read((char *)header, sizeof(header));
+    if (!file || memcmp(magic, FLIP_MAGIC, sizeof(magic)) != 0 || header[0] != FLIP_VERSION) return false;
+    if (header[3] == 0) return false;
+
+    book.width = header[1];
+    book.height = header[2];
+    book.keyframe.resize((size_t)book.width * book.height * 4);
+    file.read((char *)book.keyframe.data(), book.keyframe.size());
+    book.frames.resize(header[3]);
+    for (flipbookFrame &frame : book.frames) {
+        file.read((char *)&frame.rect, sizeof(frame.rect));
+        if (!file || frame.rect.x + frame.rect.width > (uint32_t)book.width || frame.rect.y + frame.rect.height > (uint32_t)book.height) return false;
+        frame.pixels.resize((size_t)frame.rect.width * frame.rect.height * 4);
+        file.read((char *)frame.pixels.data(), frame.pixels.size());
+    }
+    book.fileBytes = (long long)file.tellg();
+    return (bool)file;
+}
@@ -0,0 +1,209 @@
+/**
+ * File contains the end-to-end frame benchmark. It plays a fixed, scripted scenario on the
+ * real scene, ticking and drawing in lockstep into an offscreen target as fast as it can,
+ * and reports the frame times as JSON. Needs no GPU, e.g. under Mesa's software renderer:
+ *   xvfb-run -a env LIBGL_ALWAYS_SOFTWARE=1 ./ass1 --frame-bench results.json
+ * or without a display server at all, in a build with ASS1_HEADLESS_EGL:
+ *   LIBGL_ALWAYS_SOFTWARE=1 ./ass1 --frame-bench results.json --headless
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Every run of the benchmark uses the same seed, so runs can be compared
+const uint32_t FRAME_BENCH_SEED = 3421;
+
+/**
+ * The parts of a frame that are timed separately
+ */
+enum benchPhase {
+    PHASE_INPUT,
+    PHASE_TICK,
+    PHASE_SNAPSHOT,
+    PHASE_DRAW,
+    PHASE_GPU,
+    TOTAL_PHASES
+};
+
+const char *BENCH_PHASE_NAMES[TOTAL_PHASES] = {"input", "tick", "snapshot", "draw", "gpu"};
+
+/**
+ * A stretch of the scenario and how many ticks it lasts
+ */
+struct benchSegment {
+    const char *name;
+    int ticks;
+};
+
+const benchSegment BENCH_SCRIPT[] = {
+    {"menu", 300},      // The menu animating before any key is pressed
+    {"menu_skip", 300}, // The menu scrolling away once it is skipped
+    {"walking", 300},   // Walking right, then left
+    {"jumping", 300},   // A jump every 30 ticks
+    {"storm", 600},     // Every snowflake spawning at once
+};
+const int BENCH_SEGMENTS = sizeof(BENCH_SCRIPT) / sizeof(BENCH_SCRIPT[0]);
+
+/**
+ * Presses the keys the script calls for at the given tick of a segment
+ * @param now when the keys are pressed, in seconds. Not from glfwGetTime, as GLFW is not
+ * running in a headless run
+ * @param gameState whether the menu has started scrolling. Set when the menu is skipped
+ */
+template <typename Config>
+void applyBenchScript(scene<Config> &sceneObjects, int segment, int tick, double now, bool &gameState) {
+    switch (segment) {
+        case 1:
+            // The same as the menu being auto-skipped
+            if (tick == 0) gameState = true;
+            break;
+        case 2:
+            if (tick == 0) sceneObjects.input.inject(ACTION_WALK_RIGHT, true, now);
+            if (tick == BENCH_SCRIPT[segment].ticks / 2) {
+                sceneObjects.input.inject(ACTION_WALK_RIGHT, false, now);
+                sceneObjects.input.inject(ACTION_WALK_LEFT, true, now);
+            }
+            if (tick == BENCH_SCRIPT[segment].ticks - 1) sceneObjects.input.inject(ACTION_WALK_LEFT, false, now);
+            break;
+        case 3:
+            if (tick % 30 == 0) sceneObjects.input.inject(ACTION_JUMP, true, now);
+            if (tick % 30 == 1) sceneObjects.input.inject(ACTION_JUMP, false, now);
+            break;
+        case 4:
+            // Every flake spawns at the top at once
+            if (tick == 0) {
+                sceneObjects.flakeBudget = Config::FLAKE_TOTAL;
+                for (int i = 0; i < Config::FLAKE_TOTAL; i++) {
+                    sceneObjects.spawnFlake(i, gameState);
+                }
+            }
+            break;
+    }
+}
+
+/**
+ * Gets a percentile of values that are already sorted
+ */
+double sortedPercentile(const std::vector<double> &sorted, double percentile) {
+    if (sorted.empty()) return 0;
+    size_t index = std::min(sorted.size() - 1, (size_t)(percentile / 100 * sorted.size()));
+    return sorted[index];
+}
+
+/**
+ * Writes the frame count, frames per second and frame time percentiles of a set of frames
+ */
+void writeFrameStats(std::ostream &out, std::vector<double> frameMs) {
+    double total = 0;
+    for (double ms : frameMs) total += ms;
+    std::sort(frameMs.begin(), frameMs.end());
+    out << "\"frames\": " << frameMs.size() << ", \"fps\": " << (total > 0 ? 1000 * frameMs.size() / total : 0)
+        << ", \"frame_ms\": {\"mean\": " << (frameMs.empty() ? 0 : total / frameMs.size())
+        << ", \"p50\": " << sortedPercentile(frameMs, 50) << ", \"p90\": " << sortedPercentile(frameMs, 90)
+        << ", \"p99\": " << sortedPercentile(frameMs, 99) << ", \"max\": " << (frameMs.empty() ? 0 : frameMs.back()) << "}";
+}
+
+/**
+ * Runs the scripted scenario and writes its results as JSON to the console and to a file.
+ * The scene must already be set up. Each frame waits for the GPU to finish, so the GPU
+ * phase is the time spent drawing rather than queueing
+ * @return bool whether the results could be written
+ */
+template <typename Config>
+bool runFrameBench(scene<Config> &sceneObjects, snapshotRenderer &renderer, GLuint program, const std::string &outputPath) {
+    using namespace std::chrono;
+
+    lowResTarget target;
+    target.resize(Config::SCREEN_WIDTH, Config::SCREEN_HEIGHT);
+    renderSnapshot snapshot;
+    bool gameState = false;
+
+    // Frame times of each segment, and the total time of each phase
+    std::vector<std::vector<double>> segmentFrameMs(BENCH_SEGMENTS);
+    // Most snowflakes alive at once in each segment, to check the script did what it meant to
+    std::vector<int> segmentPeakFlakes(BENCH_SEGMENTS);
+    double phaseMs[TOTAL_PHASES] = {};
+
+    printMessageTime();
+    std::cout << "Running frame benchmark on " << glGetString(GL_RENDERER) << "\n";
+    for (int segment = 0; segment < BENCH_SEGMENTS; segment++) {
+        for (int tick = 0; tick < BENCH_SCRIPT[segment].ticks; tick++) {
+            steady_clock::time_point phaseEnds[TOTAL_PHASES + 1];
+            phaseEnds[0] = steady_clock::now();
+
+            applyBenchScript(sceneObjects, segment, tick, duration<double>(phaseEnds[0].time_since_epoch()).count(), gameState);
+            sceneObjects.checkKeyInputs();
+            phaseEnds[PHASE_INPUT + 1] = steady_clock::now();
+
+            sceneObjects.tickAll(gameState);
+            phaseEnds[PHASE_TICK + 1] = steady_clock::now();
+
+            sceneObjects.fillSnapshot(snapshot);
+            phaseEnds[PHASE_SNAPSHOT + 1] = steady_clock::now();
+            segmentPeakFlakes[segment] = std::max(segmentPeakFlakes[segment], snapshot.activeFlakes);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+            glViewport(0, 0, target.width, target.height);
+            glClearColor(0, 0, 0, 1);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glUseProgram(program);
+            sceneObjects.mainMenuObj.menuAnimation.showFrame(snapshot.menuFrame);
+            sceneObjects.sceneryTextures.update();
+            sceneObjects.chunks.update(snapshot.chunkEpoch);
+            renderer.draw(snapshot);
+            glUseProgram(0);
+            phaseEnds[PHASE_DRAW + 1] = steady_clock::now();
+
+            glFinish();
+            phaseEnds[PHASE_GPU + 1] = steady_clock::now();
+
+            for (int phase = 0; phase < TOTAL_PHASES; phase++) {
+                phaseMs[phase] += duration<double, std::milli>(phaseEnds[phase + 1] - phaseEnds[phase]).count();
+            }
+            segmentFrameMs[segment].push_back(duration<double, std::milli>(phaseEnds[TOTAL_PHASES] - phaseEnds[0]).count());
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    target.deleteSelf();
+
+    std::vector<double> allFrameMs;
+    for (const std::vector<double> &frameMs : segmentFrameMs) {
+        allFrameMs.insert(allFrameMs.end(), frameMs.begin(), frameMs.end());
+    }
+
+    auto writeJson = [&](std::ostream &out) {
+        out << "{\n  \"seed\": " << FRAME_BENCH_SEED << ", \"renderer\": \"" << glGetString(GL_RENDERER)
+            << "\", \"width\": " << Config::SCREEN_WIDTH << ", \"height\": " << Config::SCREEN_HEIGHT << ",\n  ";
+        writeFrameStats(out, allFrameMs);
+        out << ",\n  \"phase_ms\": {";
+        for (int phase = 0; phase < TOTAL_PHASES; phase++) {
+            out << "\"" << BENCH_PHASE_NAMES[phase] << "\": " << phaseMs[phase] / allFrameMs.size()
+                << ((phase + 1 < TOTAL_PHASES) ? ", " : "");
+        }
+        out << "},\n  \"segments\": [\n";
+        for (int segment = 0; segment < BENCH_SEGMENTS; segment++) {
+            out << "    {\"name\": \"" << BENCH_SCRIPT[segment].name << "\", ";
+            writeFrameStats(out, segmentFrameMs[segment]);
+            out << ", \"peak_flakes\": " << segmentPeakFlakes[segment] << "}" << ((segment + 1 < BENCH_SEGMENTS) ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    };
+
+    writeJson(std::cout);
+    std::ofstream outFile(outputPath);
+    writeJson(outFile);
+    return (bool)outFile;
+}
@@ -0,0 +1,84 @@
+/**
+ * File contains frameScheduler, which decides when the render loop should draw. A frame
+ * is only drawn and presented when a new tick was published or the window needs to be
+ * redrawn; the rest of the time the render loop sleeps on the window's events
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+
+/**
+ * Puts the render loop to sleep between ticks and counts how many of its wake ups
+ * actually presented a frame
+ */
+template <typename Config>
+struct frameScheduler {
+private:
+    // Set by anything outside the render loop that needs the window drawn again
+    std::atomic<bool> redrawRequested{true};
+    long presentedFrames = 0;
+    long skippedFrames = 0;
+
+    // CPU time of the whole process and wall time since the scheduler was made
+    std::clock_t cpuStart = std::clock();
+    std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+
+public:
+    /**
+     * Asks for the next wake up to draw even if there is no new tick. Used when the
+     * window is resized, exposed or otherwise changed
+     */
+    void requestRedraw() {
+        redrawRequested = true;
+    }
+
+    /**
+     * Wakes the render loop up after a tick was published. Safe to call from any thread
+     */
+    void notifyTick() {
+        glfwPostEmptyEvent();
+    }
+
+    /**
+     * Sleeps until a window event arrives or a tick is published. Waits at most two
+     * ticks in case a wake up is missed
+     */
+    void waitForWork() {
+        glfwWaitEventsTimeout(2 * Config::TICKS_TO_SECOND / 1000.0);
+    }
+
+    /**
+     * Decides whether this wake up should draw and present a frame
+     * @param newSnapshot whether a tick was published since the last frame
+     */
+    bool shouldPresent(bool newSnapshot) {
+        if (redrawRequested.exchange(false) || newSnapshot) {
+            presentedFrames++;
+            return true;
+        }
+        skippedFrames++;
+        return false;
+    }
+
+    /**
+     * Prints how many frames were presented and skipped, and how busy the process kept the CPU
+     */
+    void printReport() {
+        double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        double cpuSeconds = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        printMessageTime();
+        std::cout << "Frames presented: " << presentedFrames << ", skipped: " << skippedFrames
+                  << ", CPU utilisation: " << (wallSeconds > 0 ? 100 * cpuSeconds / wallSeconds : 0) << "% of one core\n";
+    }
+};
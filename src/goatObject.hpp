@@ -11,24 +11,18 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
-// Required external variables
-extern const int MAX_FRAMES_GOAT;
-extern const int ANIM_FRAME_LEN;
-extern const int AIRBORNE_LEN_MAX;
-extern const float GOAT_JUMP_ROT;
-extern const float GOAT_WALK_SPEED;
-extern const int GOAT_WALK_RANGE;
-extern const float SCROLL_SPEED;
+#include <array>
 
 /**
  * Contains everything related to the goat, including functions to control it
  * and animate it
  */
+template <typename Config>
 struct goatObject {
     shapeObject goatShape;
-    GLuint (*goatAnimationFrames) = new GLuint[MAX_FRAMES_GOAT];
+    std::array<GLuint, Config::MAX_FRAMES_GOAT> goatAnimationFrames;
 private:
-    int frameLength = ANIM_FRAME_LEN;
+    int frameLength = Config::ANIM_FRAME_LEN;
     int currFrame = 0;
     int frameLifeTime = 0;
     bool isAirBorne = false;
@@ -37,13 +31,13 @@ private:
 public:
     goatObject() {
         // Sets up each frame of the animation
-        goatAnimationFrames[0] = makeTexture("res/img/goat/goatTexture_1.png");
-        goatAnimationFrames[1] = makeTexture("res/img/goat/goatTexture_4.png");
-        goatAnimationFrames[2] = makeTexture("res/img/goat/goatTexture_2.png");
+        goatAnimationFrames[0] = makeTexture("res/img/goat/goatTexture_1.png", MEM_GOAT_FRAMES);
+        goatAnimationFrames[1] = makeTexture("res/img/goat/goatTexture_4.png", MEM_GOAT_FRAMES);
+        goatAnimationFrames[2] = makeTexture("res/img/goat/goatTexture_2.png", MEM_GOAT_FRAMES);
         goatAnimationFrames[3] = goatAnimationFrames[1];
         goatAnimationFrames[4] = goatAnimationFrames[0];
-        goatAnimationFrames[5] = makeTexture("res/img/goat/goatTexture_5.png");
-        goatAnimationFrames[6] = makeTexture("res/img/goat/goatTexture_3.png");
+        goatAnimationFrames[5] = makeTexture("res/img/goat/goatTexture_5.png", MEM_GOAT_FRAMES);
+        goatAnimationFrames[6] = makeTexture("res/img/goat/goatTexture_3.png", MEM_GOAT_FRAMES);
         goatAnimationFrames[7] = goatAnimationFrames[5];
     }
 
@@ -55,7 +49,7 @@ public:
         if (!isAirBorne) {
             if (frameLifeTime == 0) {
                 goatShape.textureID = goatAnimationFrames[currFrame];
-                currFrame = (currFrame + 1) % MAX_FRAMES_GOAT;
+                currFrame = (currFrame + 1) % Config::MAX_FRAMES_GOAT;
                 frameLifeTime = frameLength;
             } else {
                 frameLifeTime -= 1;
@@ -63,10 +57,10 @@ public:
         } else {
             // Randomly select the texture for the goat jumping
             airBorneLen++;
-            if (airBorneLen == AIRBORNE_LEN_MAX) {
+            if (airBorneLen == Config::AIRBORNE_LEN_MAX) {
                 // Lands the goat back onto the ground
                 airBorneLen = 0;
-                goatShape.rot = glm::rotate(goatShape.rot, glm::radians(-GOAT_JUMP_ROT), glm::vec3(0.0, 0.0, 1.0));
+                goatShape.rot = glm::rotate(goatShape.rot, glm::radians(-Config::GOAT_JUMP_ROT), glm::vec3(0.0, 0.0, 1.0));
                 isAirBorne = false;
             } else {
                 // Draws out a differentiated parabola on how far the shape goes up
@@ -79,6 +73,20 @@ public:
         }
     }
 
+    /**
+     * Saves or restores the goat through a stateStream
+     */
+    template <typename Stream>
+    void transferState(Stream &stream) {
+        stream.shape(goatShape);
+        stream.field(frameLength);
+        stream.field(currFrame);
+        stream.field(frameLifeTime);
+        stream.field(isAirBorne);
+        stream.field(airBorneLen);
+        stream.field(walkedDistance);
+    }
+
     /**
      * Changes the length of each frame for the goat's walk cycle
      */
@@ -111,9 +119,9 @@ public:
      * Translate the goat to the right
      */
     void walkRight() {
-        if (walkedDistance < GOAT_WALK_RANGE) {
-            walkedDistance += GOAT_WALK_SPEED;
-            goatShape.trans = glm::translate(goatShape.trans, glm::vec3(GOAT_WALK_SPEED, 0.0, 0.0));
+        if (walkedDistance < Config::GOAT_WALK_RANGE) {
+            walkedDistance += Config::GOAT_WALK_SPEED;
+            goatShape.trans = glm::translate(goatShape.trans, glm::vec3(Config::GOAT_WALK_SPEED, 0.0, 0.0));
         }
     }
 
@@ -121,9 +129,9 @@ public:
      * Translate the goat to the left
      */
     void walkLeft() {
-        if (walkedDistance > -GOAT_WALK_RANGE) {
-            walkedDistance += -SCROLL_SPEED;
-            goatShape.trans = glm::translate(goatShape.trans, glm::vec3(-SCROLL_SPEED, 0.0, 0.0));
+        if (walkedDistance > -Config::GOAT_WALK_RANGE) {
+            walkedDistance += -Config::SCROLL_SPEED;
+            goatShape.trans = glm::translate(goatShape.trans, glm::vec3(-Config::SCROLL_SPEED, 0.0, 0.0));
         }
     }
 
@@ -135,7 +143,7 @@ public:
         if (!isAirBorne) {
             isAirBorne = true;
             // Rotate the goat a bit on jump
-            goatShape.rot = glm::rotate(goatShape.rot, glm::radians(GOAT_JUMP_ROT), glm::vec3(0.0, 0.0, 1.0));
+            goatShape.rot = glm::rotate(goatShape.rot, glm::radians(Config::GOAT_JUMP_ROT), glm::vec3(0.0, 0.0, 1.0));
             // Selects the jumping frame that is closest to the current frame
             if (abs(currFrame - 2) < abs(currFrame - 6)) {
                 goatShape.textureID = goatAnimationFrames[2];
@@ -148,7 +156,6 @@ public:
     }
 
     void deleteSelf() {
-        delete[] goatAnimationFrames;
         goatShape.deleteSelf();
     }
 };
\ No newline at end of file
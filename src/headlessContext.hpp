@@ -0,0 +1,79 @@
+/**
+ * File contains headlessContext, an OpenGL context made through EGL on Mesa's surfaceless
+ * platform, so it needs no window, X server or Wayland compositor. There is no default
+ * framebuffer, so everything has to be drawn into framebuffer objects. Only available
+ * when built with -DASS1_HEADLESS_EGL=ON
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#ifdef ASS1_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+/**
+ * An OpenGL 3.3 core context with no surface. Used in place of the window
+ */
+struct headlessContext {
+#ifdef ASS1_HEADLESS_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+#endif
+
+    /**
+     * Makes the context and makes it current on this thread
+     */
+    void create() {
+#ifdef ASS1_HEADLESS_EGL
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        chicken3421::expect(getPlatformDisplay != nullptr, "EGL does not support EGL_EXT_platform_base");
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        chicken3421::expect(display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr), "Could not open a surfaceless EGL display");
+
+        const EGLint configAttribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        chicken3421::expect(eglChooseConfig(display, configAttribs, &config, 1, &configCount) && configCount > 0, "No EGL config can render OpenGL");
+
+        // The same version and profile chicken3421 asks GLFW for
+        chicken3421::expect(eglBindAPI(EGL_OPENGL_API), "EGL does not support desktop OpenGL");
+        const EGLint contextAttribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+        chicken3421::expect(context != EGL_NO_CONTEXT, "Could not create an OpenGL 3.3 core context");
+        chicken3421::expect(eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context), "EGL does not support surfaceless contexts");
+        chicken3421::expect(gladLoadGLLoader((GLADloadproc)eglGetProcAddress), "Could not load OpenGL functions");
+
+        printMessageTime();
+        std::cout << "Headless context on " << glGetString(GL_RENDERER) << "\n";
+#else
+        chicken3421::expect(false, "Built without headless support. Reconfigure with -DASS1_HEADLESS_EGL=ON");
+#endif
+    }
+
+    void destroy() {
+#ifdef ASS1_HEADLESS_EGL
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+        context = EGL_NO_CONTEXT;
+#endif
+    }
+};
@@ -11,16 +11,73 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
 // Keeps track of every image and textures created in the code
 std::list<chicken3421::image_t> listOfEveryImage;
 std::list<GLuint> listOfEveryTexID;
+// The palette texture of every index texture
+std::unordered_map<GLuint, GLuint> paletteOfTexture;
+
+/**
+ * How much of a texture can be seen through, which decides the pass it is drawn in
+ */
+enum textureAlpha {
+    ALPHA_OPAQUE,  // Every pixel is fully opaque
+    ALPHA_BINARY,  // Pixels are either fully opaque or fully transparent
+    ALPHA_BLENDED  // Has half transparent pixels that need blending
+};
+// How much of every texture loaded from an image can be seen through
+std::unordered_map<GLuint, textureAlpha> alphaOfTexture;
+
+// State of the random number generator. Every random decision in the program comes from
+// here, so a run can be repeated exactly from its seed
+uint64_t rdmState = 0x9E3779B97F4A7C15ull;
+const int RDM_MAX = 0x7fffffff;
+
+/**
+ * Restarts the random number generator from the given seed
+ */
+void seedRdm(uint32_t seed) {
+    // Multiplying by an odd constant keeps the state from ever being 0
+    rdmState = (seed + 1ull) * 0x9E3779B97F4A7C15ull;
+}
+
+/**
+ * Randomly generates a number between 0 and RDM_MAX (xorshift64*). Used in place of rand()
+ * @return int
+ */
+int rdmInt() {
+    rdmState ^= rdmState >> 12;
+    rdmState ^= rdmState << 25;
+    rdmState ^= rdmState >> 27;
+    return (int)((rdmState * 0x2545F4914F6CDD1Dull) >> 33);
+}
 
 /**
  * Randomly generates a number between -1 to 1 
  * @return float
  */
 float rdmNumGen() {
-    return static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
+    return static_cast <float> (rdmInt()) / static_cast <float> (RDM_MAX);
+}
+
+/**
+ * Adds some bytes onto an FNV-1a hash
+ * @param hash the hash so far, start with 2166136261
+ * @return uint32_t the new hash
+ */
+uint32_t hashBytes(uint32_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
 }
 
 /**
@@ -31,47 +88,112 @@ float rdmNumGen() {
  */
 std::string appendRdmNum(const std::string &fileName, int minRng, int maxRng) {
     std::string returnName = fileName.c_str();
-    int rng = minRng + (rand() % (maxRng - minRng + 1));
+    int rng = minRng + (rdmInt() % (maxRng - minRng + 1));
     returnName.append(std::to_string(rng));
     returnName.append(".png");
     return returnName;
 }
 
+/**
+ * Works out how much of a texture can be seen through from how many of its pixels have
+ * each alpha value. Pixel art with a stray half transparent pixel (at most 1 in 100 of
+ * the visible ones) is counted as binary, as rounding those pixels is not noticeable
+ * @param alphaCounts number of pixels with each alpha value
+ * @return textureAlpha
+ */
+textureAlpha classifyAlpha(const size_t alphaCounts[256]) {
+    size_t partial = 0;
+    for (int alpha = 1; alpha < 255; alpha++) partial += alphaCounts[alpha];
+    size_t visible = partial + alphaCounts[255];
+    if (alphaCounts[0] == 0 && partial == 0) return ALPHA_OPAQUE;
+    if (partial * 100 <= visible) return ALPHA_BINARY;
+    return ALPHA_BLENDED;
+}
+
+/**
+ * Works out how much of an image can be seen through
+ * @param channels 3 for RGB, 4 for RGBA
+ */
+textureAlpha alphaOfPixels(const unsigned char *pixels, size_t pixelCount, int channels) {
+    size_t alphaCounts[256] = {};
+    for (size_t pixel = 0; pixel < pixelCount; pixel++) {
+        alphaCounts[(channels == 4) ? pixels[pixel * 4 + 3] : 255]++;
+    }
+    return classifyAlpha(alphaCounts);
+}
+
+/**
+ * Works out how much of a palettised image can be seen through
+ */
+textureAlpha alphaOfIndexed(const palettisedImage &img) {
+    size_t alphaCounts[256] = {};
+    for (unsigned char index : img.indices) {
+        alphaCounts[img.palette[index * 4 + 3]]++;
+    }
+    return classifyAlpha(alphaCounts);
+}
+
+/**
+ * How much of a texture can be seen through. Textures that were not loaded from an image
+ * are assumed to need blending
+ * @return textureAlpha
+ */
+textureAlpha alphaOf(GLuint tex) {
+    auto found = alphaOfTexture.find(tex);
+    return (found != alphaOfTexture.end()) ? found->second : ALPHA_BLENDED;
+}
+
+/**
+ * Reads and decodes an image file like chicken3421::load_image, but also says how big the
+ * file was. Free the image with chicken3421::delete_image. Does not touch OpenGL or the
+ * lists of everything made, so it can be run on any thread
+ * @param fileBytes set to the number of bytes read from the file
+ * @return chicken3421::image_t
+ */
+chicken3421::image_t loadImage(const std::string &fileName, long long &fileBytes) {
+    std::ifstream file(fileName, std::ios::binary);
+    chicken3421::expect((bool)file, "Could not open image " + fileName);
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    fileBytes = (long long)bytes.size();
+
+    chicken3421::image_t loadedImage;
+    loadedImage.data = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &loadedImage.width, &loadedImage.height, &loadedImage.n_channels, 0);
+    chicken3421::expect(loadedImage.data != nullptr, "Could not load image " + fileName);
+    return loadedImage;
+}
+
 /**
  * Creates an image with the given filename
- * @param string
+ * @param fileBytes set to the number of bytes read from the file
  * @return chicken3421::image_t
  */
-chicken3421::image_t makeImage(const std::string &fileName) {
-    chicken3421::image_t loadedImage = chicken3421::load_image(fileName);
+chicken3421::image_t makeImage(const std::string &fileName, long long &fileBytes) {
+    chicken3421::image_t loadedImage = loadImage(fileName, fileBytes);
     listOfEveryImage.push_back(loadedImage);
+    memTracker.addCpu(MEM_CPU_IMAGES, (long long)loadedImage.width * loadedImage.height * loadedImage.n_channels);
     return loadedImage;
 }
 
 /**
- * Creates the texture with the image at the given filename
+ * Creates an image with the given filename
  * @param string
- * @return GLuint texture handler
+ * @return chicken3421::image_t
  */
-GLuint makeTexture(const std::string &fileName) {
-
-    chicken3421::image_t texImg = makeImage(fileName);
-    GLint format;
-    if (texImg.n_channels == 3) {
-        format = GL_RGB;
-    } else {
-        format = GL_RGBA;
-    }
-
-    // Enabling transparent pixels
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    GLuint tex;
-    glGenTextures(1, &tex);
+chicken3421::image_t makeImage(const std::string &fileName) {
+    long long fileBytes;
+    return makeImage(fileName, fileBytes);
+}
 
+/**
+ * Replaces the pixels of a texture, giving it the settings used for the pixel art
+ * @param GLint internalFormat format the texture is stored as on the GPU
+ * @param GLenum format format of the given pixels
+ */
+void fillTexture(GLuint tex, GLint internalFormat, GLenum format, int width, int height, const void *pixels) {
     glBindTexture(GL_TEXTURE_2D, tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, texImg.width, texImg.height, 0, format, GL_UNSIGNED_BYTE, texImg.data);
+    // Rows of single channel and RGB images are not always a multiple of 4 bytes long
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
 
     // Have filter to be GL_NEAREST to replicate the Minecraft pixel art
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -82,26 +204,148 @@ GLuint makeTexture(const std::string &fileName) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
     glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/**
+ * Uploads pixels into a new texture with the settings used for the pixel art
+ * @param GLint internalFormat format the texture is stored as on the GPU
+ * @param GLenum format format of the given pixels
+ * @return GLuint texture handler
+ */
+GLuint uploadTexture(GLint internalFormat, GLenum format, int width, int height, const void *pixels) {
+    GLuint tex;
+    glGenTextures(1, &tex);
+    fillTexture(tex, internalFormat, format, width, height, pixels);
 
     listOfEveryTexID.push_back(tex);
+    return tex;
+}
 
+/**
+ * Creates a 256x1 palette texture. Entries past paletteSize are left transparent
+ * @param rgba paletteSize colours, 4 bytes each
+ * @return GLuint texture handler
+ */
+GLuint makePaletteTexture(const unsigned char *rgba, int paletteSize, memSubsystem subsystem) {
+    unsigned char fullPalette[MAX_PALETTE_SIZE * 4] = {};
+    memcpy(fullPalette, rgba, paletteSize * 4);
+    GLuint palette = uploadTexture(GL_RGBA8, GL_RGBA, MAX_PALETTE_SIZE, 1, fullPalette);
+    memTracker.trackTexture(palette, subsystem, MAX_PALETTE_SIZE, 1, 4);
+    return palette;
+}
+
+/**
+ * Creates an 8-bit index texture and the palette it looks its colours up in
+ * @return GLuint texture handler of the index texture
+ */
+GLuint makeIndexedTexture(const palettisedImage &img, memSubsystem subsystem) {
+    GLuint tex = uploadTexture(GL_R8, GL_RED, img.width, img.height, img.indices.data());
+    memTracker.trackTexture(tex, subsystem, img.width, img.height, 1);
+    paletteOfTexture[tex] = makePaletteTexture(img.palette.data(), img.paletteSize, subsystem);
+    alphaOfTexture[tex] = alphaOfIndexed(img);
     return tex;
 }
 
+/**
+ * Creates the texture with the image at the given filename. Pixel art with few enough
+ * colours is stored as an index texture, preferring an up to date .ipal file made by
+ * ass1_assettool and otherwise palettising the image as it is loaded. The decode and upload are timed
+ * while the program is starting up
+ * @param string
+ * @param memSubsystem what the texture's memory is counted against
+ * @return GLuint texture handler
+ */
+GLuint makeTexture(const std::string &fileName, memSubsystem subsystem = MEM_OTHER_TEXTURES) {
+    startupTimer timer;
+    palettisedImage indexedImg;
+    if (appConfig::PALETTE_TEXTURES && readCurrentPalettisedImage(fileName, indexedImg)) {
+        timer.lap(fileName, STARTUP_DECODE, indexedImg.fileBytes);
+        GLuint tex = makeIndexedTexture(indexedImg, subsystem);
+        timer.lap(fileName, STARTUP_UPLOAD);
+        return tex;
+    }
+
+    long long fileBytes;
+    chicken3421::image_t texImg = makeImage(fileName, fileBytes);
+    bool indexed = appConfig::PALETTE_TEXTURES && palettiseImage((unsigned char *)texImg.data, texImg.width, texImg.height, texImg.n_channels, indexedImg);
+    timer.lap(fileName, STARTUP_DECODE, fileBytes);
+    if (indexed) {
+        GLuint tex = makeIndexedTexture(indexedImg, subsystem);
+        timer.lap(fileName, STARTUP_UPLOAD);
+        return tex;
+    }
+
+    GLint format;
+    if (texImg.n_channels == 3) {
+        format = GL_RGB;
+    } else {
+        format = GL_RGBA;
+    }
+
+    GLuint tex = uploadTexture(format, format, texImg.width, texImg.height, texImg.data);
+    // Drivers usually pad RGB textures out to 4 bytes per texel
+    memTracker.trackTexture(tex, subsystem, texImg.width, texImg.height, 4);
+    alphaOfTexture[tex] = alphaOfPixels((const unsigned char *)texImg.data, (size_t)texImg.width * texImg.height, texImg.n_channels);
+    timer.lap(fileName, STARTUP_UPLOAD);
+
+    return tex;
+}
+
+/**
+ * Binds a texture for drawing, along with its palette if it is an index texture
+ * @param GLint palettedLoc location of the shader's "paletted" uniform
+ */
+void bindTexture(GLuint tex, GLint palettedLoc) {
+    glBindTexture(GL_TEXTURE_2D, tex);
+    auto found = paletteOfTexture.find(tex);
+    bool paletted = found != paletteOfTexture.end();
+    if (paletted) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, found->second);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    glUniform1i(palettedLoc, paletted);
+}
+
 
 /**
  * Prints the system time without \n at the end
  */
 void printMessageTime() {
     auto currTime = time(0);
-    char *chrTime = std::ctime(&currTime);
-    std::string strTime(chrTime);
-    // Removes the endline character from the string
-    strTime.pop_back();
-    std::cout << "\u001b[32m[" << strTime.c_str() << "]\033[0m ";
+    const char *chrTime = std::ctime(&currTime);
+    // Leaves out the endline character. Written straight from ctime's buffer so nothing is allocated
+    std::cout << "\u001b[32m[";
+    std::cout.write(chrTime, strlen(chrTime) - 1);
+    std::cout << "]\033[0m ";
     return;
 }
 
+/**
+ * Finds where a texture is in listOfEveryTexID. Textures are made in the same order
+ * every run, so this identifies a texture across runs
+ * @return int the position, or -1 if it is not a texture that was made
+ */
+int textureIndex(GLuint tex) {
+    int index = 0;
+    for (GLuint made : listOfEveryTexID) {
+        if (made == tex) return index;
+        index++;
+    }
+    return -1;
+}
+
+/**
+ * Opposite of textureIndex
+ * @return GLuint the texture, or 0 if there is no texture at that position
+ */
+GLuint textureAtIndex(int index) {
+    for (GLuint made : listOfEveryTexID) {
+        if (index-- == 0) return made;
+    }
+    return 0;
+}
+
 /**
  * Uses the global variables that contains pointers to all texture IDs
  * and images and deletes them all
@@ -113,14 +357,19 @@ void deleteAllTexImg() {
         std::cout << "Deleted tex: " << &listOfEveryTexID.front() << "\n";
         */
         glDeleteTextures(1, &listOfEveryTexID.front());
+        memTracker.untrackTexture(listOfEveryTexID.front());
         listOfEveryTexID.pop_front();
     }
+    paletteOfTexture.clear();
+    alphaOfTexture.clear();
     while (listOfEveryImage.size() > 0) {
         /*
         printMessageTime();
         std::cout << "Deleted img: " << listOfEveryImage.front().data << "\n";
         */
-        chicken3421::delete_image(listOfEveryImage.front());
+        chicken3421::image_t &img = listOfEveryImage.front();
+        memTracker.addCpu(MEM_CPU_IMAGES, -(long long)img.width * img.height * img.n_channels);
+        chicken3421::delete_image(img);
         listOfEveryImage.pop_front();
     }
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+/**
+ * File contains the inputQueue struct, which collects timestamped key events as they
+ * arrive and turns them into the state of each bound action at the start of a tick
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+/**
+ * Everything a key can be bound to. Listed in the order they are handled each tick
+ */
+enum inputAction {
+    ACTION_JUMP,
+    ACTION_WALK_LEFT,
+    ACTION_WALK_RIGHT,
+    ACTION_FULLSCREEN,
+    ACTION_MEMORY_REPORT,
+    ACTION_QUIT,
+    ACTION_TOGGLE_OVERLAY,
+    ACTION_TOGGLE_HUD,
+    ACTION_TOTAL
+};
+
+/**
+ * Ties a key to the action it performs
+ */
+struct keyBinding {
+    int key;
+    inputAction action;
+};
+
+const keyBinding KEY_BINDINGS[] = {
+    {GLFW_KEY_SPACE,  ACTION_JUMP},
+    {GLFW_KEY_A,      ACTION_WALK_LEFT},
+    {GLFW_KEY_D,      ACTION_WALK_RIGHT},
+    {GLFW_KEY_F,      ACTION_FULLSCREEN},
+    {GLFW_KEY_M,      ACTION_MEMORY_REPORT},
+    {GLFW_KEY_ESCAPE, ACTION_QUIT},
+    {GLFW_KEY_TAB,    ACTION_TOGGLE_OVERLAY},
+    {GLFW_KEY_F3,     ACTION_TOGGLE_HUD},
+};
+
+/**
+ * A single press or release of a bound key
+ */
+struct inputEvent {
+    inputAction action;
+    bool pressed;
+    double time;  // Seconds, from glfwGetTime
+};
+
+/**
+ * Queues key events and applies them in order at tick boundaries. A key that is
+ * pressed and released within the same tick still counts as held for that tick.
+ * Events are pushed by the window thread and applied by the simulation thread
+ */
+struct inputQueue {
+private:
+    std::mutex eventsLock;
+    std::vector<inputEvent> events;
+    std::vector<inputEvent> applying;
+    bool held[ACTION_TOTAL] = {};
+    int presses[ACTION_TOTAL] = {};
+
+    // Earliest press that has been applied but not yet shown on screen
+    double oldestUnpresented = -1;
+
+    // Input to present latency, in seconds
+    long latencySamples = 0;
+    double latencySum = 0;
+    double latencyMax = 0;
+
+public:
+    inputQueue() {
+        events.reserve(64);
+        applying.reserve(64);
+    }
+
+    /**
+     * Queues a key event. Keys without a binding and key repeats are ignored
+     * @param action GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+     */
+    void push(int key, int action, double time) {
+        if (action == GLFW_REPEAT) return;
+        std::lock_guard<std::mutex> guard(eventsLock);
+        for (const keyBinding &binding : KEY_BINDINGS) {
+            if (binding.key == key) {
+                events.push_back({binding.action, action == GLFW_PRESS, time});
+            }
+        }
+    }
+
+    /**
+     * Queues an action directly, skipping the key bindings. Used when replaying a recording
+     */
+    void inject(inputAction action, bool pressed, double time) {
+        std::lock_guard<std::mutex> guard(eventsLock);
+        events.push_back({action, pressed, time});
+    }
+
+    /**
+     * Applies every queued event in the order they arrived. Called at the start of a tick
+     */
+    void beginTick() {
+        applying.clear();
+        {
+            // Takes the queued events so the window thread is only held up for the swap
+            std::lock_guard<std::mutex> guard(eventsLock);
+            events.swap(applying);
+        }
+        for (const inputEvent &event : applying) {
+            if (event.pressed) {
+                held[event.action] = true;
+                presses[event.action]++;
+                if (oldestUnpresented < 0 || event.time < oldestUnpresented) {
+                    oldestUnpresented = event.time;
+                }
+            } else {
+                held[event.action] = false;
+            }
+        }
+    }
+
+    /**
+     * The events applied by the latest beginTick, in order. Used when recording a run
+     */
+    const std::vector<inputEvent> &appliedEvents() {
+        return applying;
+    }
+
+    /**
+     * Forgets this tick's presses. Called once the tick has handled them
+     */
+    void endTick() {
+        for (int i = 0; i < ACTION_TOTAL; i++) {
+            presses[i] = 0;
+        }
+    }
+
+    /**
+     * Whether an action is held down, or was tapped at any point since the last tick
+     */
+    bool isActive(inputAction action) {
+        return held[action] || presses[action] > 0;
+    }
+
+    /**
+     * Whether an action was pressed since the last tick. Used for actions that
+     * happen once per press
+     */
+    bool wasPressed(inputAction action) {
+        return presses[action] > 0;
+    }
+
+    /**
+     * Returns the earliest press applied since this was last called, or -1 if there
+     * were none. Used to tag the tick's snapshot so its latency can be measured
+     */
+    double takeOldestApplied() {
+        double oldest = oldestUnpresented;
+        oldestUnpresented = -1;
+        return oldest;
+    }
+
+    /**
+     * Records how long a press took to reach the screen. Only used by the render thread
+     * @param inputTime when the press happened, in seconds from glfwGetTime
+     * @param presentTime when the frame showing it was presented
+     */
+    void markPresented(double inputTime, double presentTime) {
+        if (inputTime < 0) return;
+        double latency = presentTime - inputTime;
+        latencySamples++;
+        latencySum += latency;
+        if (latency > latencyMax) latencyMax = latency;
+    }
+
+    /**
+     * Prints the average and worst input to present latency
+     */
+    void printLatencyReport() {
+        if (latencySamples == 0) return;
+        printMessageTime();
+        std::cout << "Input to present latency: average " << 1000 * latencySum / latencySamples
+                  << "ms, worst " << 1000 * latencyMax << "ms over " << latencySamples << " presses\n";
+    }
+};
@@ -0,0 +1,167 @@
+/**
+ * File contains inputRecorder and inputReplayer, which write and read back everything
+ * from outside the simulation that changed a run, so the run can be repeated exactly.
+ * Entries are keyed by tick rather than time, and every tick stores a checksum of the
+ * scene so a replay can tell when it no longer matches the recording
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// .irec file layout: magic, version, seed, then recordEntry structs until a REC_END
+const char IREC_MAGIC[4] = {'I', 'R', 'E', 'C'};
+const uint32_t IREC_VERSION = 1;
+
+/**
+ * What a recordEntry holds. Entries for a tick are written in the order they are
+ * applied, all before the tick's REC_CHECKSUM
+ */
+enum recordType : uint16_t {
+    REC_KEY,          // action: inputAction, a: 1 if pressed
+    REC_RESIZE,       // a: width, b: height
+    REC_GAME_START,   // The menu started scrolling
+    REC_FLAKE_BUDGET, // a: new budget
+    REC_CHECKSUM,     // a: checksum of the scene after the tick
+    REC_END           // The last tick of the recording
+};
+
+/**
+ * A single entry in a recording. Always 16 bytes
+ */
+struct recordEntry {
+    uint32_t tick;
+    uint16_t type;
+    uint16_t action;
+    int32_t a;
+    int32_t b;
+};
+
+/**
+ * Writes a recording as the run goes. Only used by the simulation thread
+ */
+struct inputRecorder {
+private:
+    std::ofstream file;
+
+public:
+    /**
+     * Starts a recording
+     * @return bool whether the file could be opened
+     */
+    bool open(const std::string &fileName, uint32_t seed) {
+        file.open(fileName, std::ios::binary);
+        if (!file) return false;
+        uint32_t header[2] = {IREC_VERSION, seed};
+        file.write(IREC_MAGIC, sizeof(IREC_MAGIC));
+        file.write((const char *)header, sizeof(header));
+        return true;
+    }
+
+    bool isOpen() {
+        return file.is_open();
+    }
+
+    void add(long tick, recordType type, int action = 0, int a = 0, int b = 0) {
+        if (!file.is_open()) return;
+        recordEntry entry = {(uint32_t)tick, (uint16_t)type, (uint16_t)action, a, b};
+        file.write((const char *)&entry, sizeof(entry));
+    }
+
+    /**
+     * Marks the end of the recording and closes the file
+     */
+    void close(long lastTick) {
+        if (!file.is_open()) return;
+        add(lastTick, REC_END);
+        file.close();
+    }
+};
+
+/**
+ * Reads a recording and hands its entries back one tick at a time. Only used by the
+ * simulation thread
+ */
+struct inputReplayer {
+private:
+    std::vector<recordEntry> entries;
+    size_t nextEntry = 0;
+    long divergedTick = -1;
+
+public:
+    uint32_t seed = 0;
+
+    /**
+     * Reads a whole recording into memory
+     * @return bool whether the file existed and was valid
+     */
+    bool open(const std::string &fileName) {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file) return false;
+
+        char magic[4];
+        uint32_t header[2];
+        file.read(magic, sizeof(magic));
+        file.read((char *)header, sizeof(header));
+        if (!file || memcmp(magic, IREC_MAGIC, sizeof(magic)) != 0 || header[0] != IREC_VERSION) return false;
+        seed = header[1];
+
+        recordEntry entry;
+        while (file.read((char *)&entry, sizeof(entry))) {
+            entries.push_back(entry);
+        }
+        return !entries.empty() && entries.back().type == REC_END;
+    }
+
+    bool isOpen() {
+        return !entries.empty();
+    }
+
+    /**
+     * Returns the next entry to apply before the given tick, or nullptr once there are none
+     */
+    const recordEntry *nextBeforeTick(long tick) {
+        if (nextEntry >= entries.size()) return nullptr;
+        const recordEntry &entry = entries[nextEntry];
+        if ((long)entry.tick != tick || entry.type == REC_CHECKSUM || entry.type == REC_END) return nullptr;
+        nextEntry++;
+        return &entry;
+    }
+
+    /**
+     * Compares the scene after a tick with the recording. Only the first mismatch is reported
+     */
+    void checkTick(long tick, uint32_t checksum) {
+        if (nextEntry >= entries.size()) return;
+        const recordEntry &entry = entries[nextEntry];
+        if ((long)entry.tick != tick || entry.type != REC_CHECKSUM) return;
+        nextEntry++;
+        if ((uint32_t)entry.a != checksum && divergedTick < 0) {
+            divergedTick = tick;
+            printMessageTime();
+            std::cout << "Replay diverged from the recording at tick " << tick << "\n";
+        }
+    }
+
+    /**
+     * Whether every tick of the recording has been replayed
+     */
+    bool isFinished(long tick) {
+        return nextEntry >= entries.size() || (entries[nextEntry].type == REC_END && (long)entries[nextEntry].tick < tick);
+    }
+
+    /**
+     * Prints whether the replay matched the recording
+     */
+    void printSummary(long tick) {
+        printMessageTime();
+        if (divergedTick < 0) {
+            std::cout << "Replay matched the recording for all " << tick << " ticks\n";
+        } else {
+            std::cout << "Replay diverged at tick " << divergedTick << " of " << tick << "\n";
+        }
+    }
+};
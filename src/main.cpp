@@ -4,9 +4,14 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 
+#include <atomic>
+#include <cstdio>
 #include <cstdlib>
 #include <chrono>
+#include <fstream>
 #include <list>
+#include <string>
+#include <thread>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -18,115 +23,185 @@
 #include <glm/ext/matrix_transform.hpp>
 #include <iostream>
 
+#include "programSettings.hpp"
+#include "allocTracker.hpp"
+#include "memoryTracker.hpp"
+#include "startupProfiler.hpp"
+#include "palettisedImage.hpp"
+#include "flipbook.hpp"
 #include "helperFunctions.hpp"
+#include "programCache.hpp"
 #include "vert.hpp"
+#include "meshRegistry.hpp"
 #include "shapeObject.hpp"
 #include "goatObject.hpp"
 #include "snowFlakeObject.hpp"
 #include "mainMenuScene.hpp"
+#include "inputQueue.hpp"
+#include "renderSnapshot.hpp"
+#include "bitmapFont.hpp"
+#include "inputRecording.hpp"
+#include "timerWheel.hpp"
+#include "textureResidency.hpp"
+#include "sceneryChunks.hpp"
 #include "scene.hpp"
+#include "sceneState.hpp"
 #include "shapeCreation.hpp"
-
-//////////////////////
-// PROGRAM SETTINGS //
-//////////////////////
-
-// Application window settings:
-const char         *APP_TITLE         = "COMP3421 21T3 Assignment 1 [Minecraft: Goat Simulator]";
-extern const int   SCREEN_WIDTH       = 900;   // Screen width of the program
-extern const int   SCREEN_HEIGHT      = 900;   // Screen height of the program
-extern const bool  SCREENSAVER_MODE   = false; // Whether to compile this program as a screensaver or not
-extern const int   UNDEF_MOUSE_POS    = -1;    // The value to represent an undefined mouse position
-extern const int   TOTAL_KEYS         = 350;   // The total amount of possible key presses
-
-// Main menu settings
-extern const int   MAIN_MENU_TIMER    = 300;   // How log the main menu lasts on the window
-extern const int   MAX_FRAMES_MENU    = 119;   // How long the main menu animation lasts for (Must be a multiple of two - 1)
-extern const int   AUTO_SKIP_TIME     = 2800;  // How long until the animation automatically starts (2.8k = 1 minute)
-extern const int   TOTAL_SPL_TEX      = 20;    // How many variants of splash text
-extern const float SPLASH_SCALE       = 0.30;  // Scale of splash text
-extern const float SPLASH_ROT         = 12.5f; // How much the splash text is askewed
-extern const float SPLASH_POS_X       = 0.69;  // X position of splash text
-extern const float SPLASH_POS_Y       = 0.55;  // Y position of splash text
-extern const float SPLASH_AMPLITUDE   = 0.07;  // How violent the splash text bobs
-
-// Speed of animation:
-extern const int   TICKS_TO_SECOND    = 20;    // Lower value = faster; Higher value = slower;
-
-// Ground settings:
-extern const float SCROLL_SPEED       = 0.01;  // How fast the objects scroll by the screen
-extern const float GROUND_POS_Y       = -0.8;  // Y position of the ground
-extern const float GROUND_SCALE       = 0.2;   // Dimension size of ground
-extern const int   GROUND_TILES       = 20;    // How many tiles are in the shape
-
-// Background object settings:
-extern const int   FG_TIMER           = 500;   // How long foreground objects last on the screen
-extern const int   PARALLAX_TIMER     = 4;     // How long background objects last = PARALLAX_TIMER * FG_TIMER
-extern const float FG_POS_Y           = 0.9;   // Y position of the foreground objects
-extern const float FG_SCALE           = 1.5;   // Size of foreground objects
-extern const float PARALLAX_POS_Y     = 0.4;   // Y position of background objects
-extern const float PARALLAX_POS_X     = 2.0;   // X position of background objects
-extern const int   MAX_FRAMES_SKY     = 2;     // How many frames the night sky has
-extern const float MOON_SCALE         = 0.2;   // Size of the Moon
-extern const float MOON_POS_XY        = 0.6;   // X and Y position of the Moon
-extern const int   TOTAL_MOON_TEX     = 8;     // Total possible Moon phases
-extern const float FG_COOLDOWN        = 120;   // How long inbetween spawning foreground objects
-
-// Goat settings:
-extern const int   ANIM_FRAME_LEN     = 4;     // The length of the frames of the Goat's animation
-extern const int   AIRBORNE_LEN_MAX   = 15;    // Total time the Goat is in the air
-extern const int   MAX_FRAMES_GOAT    = 8;     // Total frames of the Goat's animation
-extern const float GOAT_POS_Y         = -0.275;// Y position of Goat
-extern const float GOAT_SCALE         = 0.4;   // Scale of the Goat
-extern const float GOAT_JUMP_ROT      = 5.0f;  // How many degrees the Goat rotates in its jump
-extern const float GOAT_WALK_SPEED    = 0.01;  // How far the Goat moves when "D" is pressed
-extern const int   GOAT_WALK_RANGE    = 1;     // How far from the centre of the screen the Goat can move to
-
-// Snow flake settings
-extern const int   TOTAL_SF_TEX       = 4;     // How many possible textures a snowflake can be
-extern const int   FLAKE_TOTAL        = 900;   // How many flakes are present. MUST BE AN EVEN NUMBER
-extern const int   FLAKE_TIMER        = 1600;  // How long the flakes last on the screen
-extern const float FLAKE_ROT_SPEED    = 5.0f;  // How many degrees the flakes rotate
-extern const int   FLAKE_CHANCE       = 2;     // The chance a snow flake spawns every tick (1 / FLAKE_CHANCE)
-extern const float FLAKE_SCALE        = 0.03;  // How big the flake is
-extern const float FLAKE_POS_Y        = 1.02;  // X position of where the flakes spawn
-extern const float W_AMPLITUDE        = 0.01;  // Wind's amplitude, controls how crazy the wind is
-extern const int   W_COEFFICIENT      = 8;     // Controls how short each wind bursts are. Has pi as the numerator
-extern const float W_VERT_SHIFT       = 0.005; // Controls how effective each wind bursts are
-
-// Background and Parallax Settings:
-extern const int   BG_SPAWN_CHANCE    = 400;   // The chance of background spawning (1 / BG_SPAWN_CHANCE)
-extern const int   TOTAL_FG_TEX       = 12;    // The total amount of possible foreground textures
-extern const int   TOTAL_P_TEX        = 4;     // The total amount of possible parallax textures
-extern const float TREE_LOOP_POS_Y    = 0.4;   // Y position of the looping trees in the background
+#include "qualityGovernor.hpp"
+#include "frameScheduler.hpp"
+#include "frameBench.hpp"
+#include "headlessContext.hpp"
 
 // Dynamic global variables
-bool gameState = false; // Determines if the main menu should scroll or not
-double initialMousePosX = UNDEF_MOUSE_POS, initialMousePosY = UNDEF_MOUSE_POS;
+std::atomic<bool> gameState{false}; // Determines if the main menu should scroll or not. Set by the window thread
+double initialMousePosX = appConfig::UNDEF_MOUSE_POS, initialMousePosY = appConfig::UNDEF_MOUSE_POS;
+bool replaying = false; // While replaying, keys and resizes from the window are ignored
+frameScheduler<appConfig> frames; // Decides which wake ups of the render loop draw a frame
 
 /**
  * Main function which controls everything
+ *
+ * Usage: ass1 [--record <file.irec>] [--replay <file.irec>] [--frame-times <file.csv>]
+ *             [--load-state <file.state>] [--save-state <file.state>] [--frame-bench <file.json>]
+ *             [--headless] [--startup-profile] [--startup-trace <file.json>] [--alloc-check <frames>]
+ *   --record       saves the seed, inputs and a checksum of every tick
+ *   --replay       plays a recording back tick for tick and reports if it diverges
+ *   --frame-times  writes the tick and CPU time of every frame
+ *   --load-state   starts from a saved scene instead of warming one up. A recording made
+ *                  this way must be replayed with the same state
+ *   --save-state   saves the scene when the program closes
+ *   --frame-bench  plays a scripted scenario as fast as possible without showing the
+ *                  window, and writes the frame times as JSON
+ *   --headless     (with --frame-bench) renders through a surfaceless EGL context instead
+ *                  of a window, so no display server is needed
+ *   --startup-profile  prints how long each stage of starting up and each asset took
+ *                      once the first frame is shown
+ *   --startup-trace    writes the same as a trace for chrome://tracing or ui.perfetto.dev
+ *   --alloc-check  (ass1_alloccheck only) runs the given number of frames after warming up
+ *                  and fails if they allocated anything
  */
-int main() {
+int main(int argc, char **argv) {
     printMessageTime();
     std::cout << "Program start\n";
 
-    // Creates opengl window and sets the window icon
-    GLFWwindow *win = chicken3421::make_opengl_window(SCREEN_WIDTH, SCREEN_HEIGHT, APP_TITLE);
-    chicken3421::image_t goatIcon = makeImage("res/img/goatFavicon.png");
-    GLFWimage faviconImg = {goatIcon.width, goatIcon.height, (unsigned char *)goatIcon.data};
-    glfwSetWindowIcon(win, 1, &faviconImg);
+    // Reads the command line
+    std::string recordPath, replayPath, frameTimesPath, loadStatePath, saveStatePath, frameBenchPath, startupTracePath;
+    int allocCheckFrames = 0;
+    bool headless = false, startupProfilePrint = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--record") {
+            recordPath = argv[++i];
+        } else if (i + 1 < argc && arg == "--replay") {
+            replayPath = argv[++i];
+        } else if (i + 1 < argc && arg == "--frame-times") {
+            frameTimesPath = argv[++i];
+        } else if (i + 1 < argc && arg == "--load-state") {
+            loadStatePath = argv[++i];
+        } else if (i + 1 < argc && arg == "--save-state") {
+            saveStatePath = argv[++i];
+        } else if (i + 1 < argc && arg == "--frame-bench") {
+            frameBenchPath = argv[++i];
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--startup-profile") {
+            startupProfilePrint = true;
+        } else if (i + 1 < argc && arg == "--startup-trace") {
+            startupTracePath = argv[++i];
+        } else if (i + 1 < argc && arg == "--alloc-check" && ALLOC_TRACKING) {
+            allocCheckFrames = std::max(1, atoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--record <file.irec>] [--replay <file.irec>] [--frame-times <file.csv>]"
+                      << " [--load-state <file.state>] [--save-state <file.state>] [--frame-bench <file.json>]"
+                      << " [--headless] [--startup-profile] [--startup-trace <file.json>]" << (ALLOC_TRACKING ? " [--alloc-check <frames>]" : "") << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (headless && frameBenchPath.empty()) {
+        // Only the benchmark runs without a window to take input from and present to
+        std::cerr << "--headless needs --frame-bench\n";
+        return EXIT_FAILURE;
+    }
+
+    // Seeds the random number generator before anything random is made. A replay uses
+    // the seed of its recording, a recording picks a new one
+    inputRecorder recorder;
+    inputReplayer replayer;
+    uint32_t seed = 1;
+    if (!replayPath.empty()) {
+        chicken3421::expect(replayer.open(replayPath), "Could not read recording " + replayPath);
+        seed = replayer.seed;
+        replaying = true;
+        printMessageTime();
+        std::cout << "Replaying " << replayPath << " with seed " << seed << "\n";
+    } else if (!recordPath.empty()) {
+        seed = (uint32_t)std::chrono::system_clock::now().time_since_epoch().count();
+        chicken3421::expect(recorder.open(recordPath, seed), "Could not write recording " + recordPath);
+        printMessageTime();
+        std::cout << "Recording to " << recordPath << " with seed " << seed << "\n";
+    } else if (!frameBenchPath.empty()) {
+        seed = FRAME_BENCH_SEED;
+    }
+    seedRdm(seed);
+    if (allocCheckFrames > 0) {
+        // Skips the menu so the check covers the scrolling scene
+        gameState = true;
+    }
+
+    // Times each stage of starting up. Stages run until the first frame is shown
+    startupTimer stage;
+    auto reportStartup = [&](const char *lastStage) {
+        stage.lap(lastStage, STARTUP_STAGE);
+        startupProfile.finish();
+        if (startupProfilePrint) {
+            printMessageTime();
+            std::cout << "Startup timeline:\n";
+            startupProfile.printTimeline(appConfig::STARTUP_SLOWEST);
+        }
+        if (!startupTracePath.empty()) {
+            if (startupProfile.writeTrace(startupTracePath)) {
+                printMessageTime();
+                std::cout << "Wrote startup trace to " << startupTracePath << "\n";
+            } else {
+                std::cerr << "Could not write startup trace " << startupTracePath << "\n";
+            }
+        }
+    };
+
+    // Creates opengl window and sets the window icon, or a context without a window
+    GLFWwindow *win = nullptr;
+    headlessContext headlessGL;
+    if (headless) {
+        headlessGL.create();
+    } else {
+        win = chicken3421::make_opengl_window(appConfig::SCREEN_WIDTH, appConfig::SCREEN_HEIGHT, appConfig::APP_TITLE);
+        chicken3421::image_t goatIcon = makeImage("res/img/goatFavicon.png");
+        GLFWimage faviconImg = {goatIcon.width, goatIcon.height, (unsigned char *)goatIcon.data};
+        glfwSetWindowIcon(win, 1, &faviconImg);
+        // Presents in step with the display where the driver allows it
+        glfwSwapInterval(appConfig::VSYNC ? 1 : 0);
+    }
+    stage.lap("window creation", STARTUP_STAGE);
 
     // Flips the textures
     stbi_set_flip_vertically_on_load(true);
 
-    GLuint vertShader = chicken3421::make_shader("res/shaders/vert.glsl", GL_VERTEX_SHADER);
-    GLuint fragShader = chicken3421::make_shader("res/shaders/frag.glsl", GL_FRAGMENT_SHADER);
-    GLuint renderProgram = chicken3421::make_program(vertShader, fragShader);
+    // Loads the linked program saved by the last run if the shaders and driver are the same
+    GLuint renderProgram = makeCachedProgram("res/shaders/vert.glsl", "res/shaders/frag.glsl", "res/shaders/scene.progbin");
+
+    // Index textures are bound to unit 0 and their palettes to unit 1
+    glUseProgram(renderProgram);
+    glUniform1i(glGetUniformLocation(renderProgram, "tex0"), 0);
+    glUniform1i(glGetUniformLocation(renderProgram, "palette"), 1);
+    glUseProgram(0);
+    snapshotRenderer renderer;
+    renderer.setup(renderProgram);
+    stage.lap("shader program", STARTUP_STAGE);
 
     // Initiating scene and setting window user pointer to it
-    scene sceneObjects;
-    glfwSetWindowUserPointer(win, &sceneObjects);
+    scene<appConfig> sceneObjects;
+    if (win) glfwSetWindowUserPointer(win, &sceneObjects);
+    stage.lap("scene constructor", STARTUP_STAGE);
 
     //////////////////
     // Shape making //
@@ -135,16 +210,20 @@ int main() {
     // Makes the animation frames for the main menu
     // If file is not found, use the first frame as the animation
 
-    // Creating the shape for the splash text
-    sceneObjects.mainMenuObj.splashText = createFlatSquare();
+    // Creating the shape for the splash text, with a random message laid out on it
+    fontAtlas = makeFontAtlas();
+    sceneObjects.mainMenuObj.splashText = createText(SPLASH_TEXTS[rdmInt() % SPLASH_TEXT_COUNT], TEXT_SPLASH,
+                                                     appConfig::SPLASH_WIDTH, appConfig::SPLASH_PIXEL);
     sceneObjects.mainMenuObj.mainMenu = createFlatSquare();
     sceneObjects.mainMenuObj.zID = createFlatSquare();
     sceneObjects.mainMenuObj.setupMenu();
+    stage.lap("main menu", STARTUP_STAGE);
 
     // Creating the focal point Goat and set a pointer to that goat
-    goatObject goatObj = createGoat();
+    goatObject<appConfig> goatObj = createGoat<appConfig>();
     goatObj.nextFrame();
     sceneObjects.goat = goatObj;
+    stage.lap("goat", STARTUP_STAGE);
 
     // Creating the shape for the background
     shapeObject backgroundObj = createFlatSquare();
@@ -153,6 +232,7 @@ int main() {
     // Creating the shape for the clouds
     shapeObject cloudsObj = createFlatSquare();
     cloudsObj.textureID = makeTexture("res/img/cloudsTexture.png");
+    cloudsObj.uvParallax = appConfig::CLOUD_PARALLAX;
     sceneObjects.clouds = cloudsObj;
 
     // Creating the shape for the overlay
@@ -163,34 +243,33 @@ int main() {
     // Creating the shape for the moon. The moon has a random phase
     // for each time the code runs
     shapeObject moonObj = createFlatSquare();
-    moonObj.textureID = makeTexture(appendRdmNum("res/img/moon/moon_", 1, TOTAL_MOON_TEX));
+    moonObj.textureID = makeTexture(appendRdmNum("res/img/moon/moon_", 1, appConfig::TOTAL_MOON_TEX));
     sceneObjects.moon = moonObj;
-    sceneObjects.adjustPositions(SCREEN_WIDTH, SCREEN_HEIGHT);
+    sceneObjects.adjustPositions(appConfig::SCREEN_WIDTH, appConfig::SCREEN_HEIGHT);
 
     // Creating the shape for the ground
-    shapeObject groundSceneObj = createGround(GROUND_TILES);
+    shapeObject groundSceneObj = createGround<appConfig>(appConfig::GROUND_TILES);
     groundSceneObj.textureID = makeTexture("res/img/snowyGroundTexture.png");
     sceneObjects.ground = groundSceneObj;
 
     // Creating the shape for the back mountains
     shapeObject parallaxObj = createFlatSquare();
-    parallaxObj.trans = glm::translate(parallaxObj.trans, glm::vec3(PARALLAX_POS_X, PARALLAX_POS_Y, 0.0));
+    parallaxObj.trans = glm::translate(parallaxObj.trans, glm::vec3(appConfig::PARALLAX_POS_X, appConfig::PARALLAX_POS_Y, 0.0));
     sceneObjects.parallaxObj = parallaxObj;
 
-    // Creating the shape for the background elements
-    sceneObjects.foregroundObjA = createBackgroundElement();
-    sceneObjects.foregroundObjB = createBackgroundElement();
-    sceneObjects.parallaxLoopObj = createParallaxLoop();
+    // Creating the shape for the looping trees. The props in front of them are streamed in by the scene
+    sceneObjects.parallaxLoopObj = createParallaxLoop<appConfig>();
     sceneObjects.parallaxLoopObj.textureID = makeTexture("res/img/treeParallax.png");
+    stage.lap("scenery shapes", STARTUP_STAGE);
 
     // Creating the snowflakes, with a random texture applied to each snow flake
-    GLuint variantA = makeTexture("res/img/snowFlakeATexture.png");
-    GLuint variantB = makeTexture("res/img/snowFlakeBTexture.png");
-    GLuint variantC = makeTexture("res/img/snowFlakeCTexture.png");
-    GLuint variantD = makeTexture("res/img/snowFlakeDTexture.png");
-    for (int i = 0; i < FLAKE_TOTAL; i++) {
-        sceneObjects.snowFlakes[i] = createSnowFlake();
-        switch (rand() % TOTAL_SF_TEX) {
+    GLuint variantA = makeTexture("res/img/snowFlakeATexture.png", MEM_SNOWFLAKE_SHAPES);
+    GLuint variantB = makeTexture("res/img/snowFlakeBTexture.png", MEM_SNOWFLAKE_SHAPES);
+    GLuint variantC = makeTexture("res/img/snowFlakeCTexture.png", MEM_SNOWFLAKE_SHAPES);
+    GLuint variantD = makeTexture("res/img/snowFlakeDTexture.png", MEM_SNOWFLAKE_SHAPES);
+    for (int i = 0; i < appConfig::FLAKE_TOTAL; i++) {
+        sceneObjects.snowFlakes[i] = createSnowFlake<appConfig>();
+        switch (rdmInt() % appConfig::TOTAL_SF_TEX) {
             case 0:
                 sceneObjects.snowFlakes[i].snowFlakeShape.textureID = variantA;
                 break;
@@ -205,15 +284,49 @@ int main() {
                 break;
         }
     }
-    // Tick a few frames ahead so that the first rendered frame has a chance
-    // to not look so empty
-    for (int i = 0; i < 450; i++) {
-        if (rand() % 3 == 0) {
-            sceneObjects.tickSnowFlake(gameState);
+    stage.lap("snowflakes", STARTUP_STAGE);
+    if (!loadStatePath.empty()) {
+        // Starts from a saved scene, which is already warmed up
+        std::ifstream stateFile(loadStatePath, std::ios::binary);
+        bool loadedGameState = gameState;
+        chicken3421::expect(loadSceneState(stateFile, sceneObjects, loadedGameState), "Could not load scene state " + loadStatePath);
+        gameState = loadedGameState;
+        printMessageTime();
+        std::cout << "Loaded scene state from " << loadStatePath << "\n";
+    } else {
+        // Tick a few frames ahead so that the first rendered frame has a chance
+        // to not look so empty
+        for (int i = 0; i < 450; i++) {
+            sceneObjects.tickTimers();
+            if (rdmInt() % 3 == 0) {
+                sceneObjects.tickSnowFlake(gameState);
+            }
+            sceneObjects.tickParallax();
         }
-        sceneObjects.tickFgObjA();
-        sceneObjects.tickFgObjB();
-        sceneObjects.tickParallax();
+        // Counted from the first real tick. A loaded scene carries its own countdown
+        sceneObjects.timers.schedule(TIMER_AUTO_SKIP, appConfig::AUTO_SKIP_TIME);
+    }
+    stage.lap(loadStatePath.empty() ? "pre-warm" : "load state", STARTUP_STAGE);
+    // The first frame shows the scenery spawned so far
+    sceneObjects.chunks.finishGenerating();
+    sceneObjects.sceneryTextures.finishDecoding();
+    stage.lap("scenery textures", STARTUP_STAGE);
+
+    printMessageTime();
+    std::cout << "Every shape shares " << meshes.size() << " distinct meshes\n";
+
+    if (!frameBenchPath.empty()) {
+        // Runs the benchmark instead of the program. Nothing is shown on the window
+        if (win) glfwHideWindow(win);
+        reportStartup("frame benchmark setup");
+        bool written = runFrameBench(sceneObjects, renderer, renderProgram, frameBenchPath);
+        chicken3421::delete_program(renderProgram);
+        sceneObjects.deleteAllShapes();
+        meshes.deleteAll();
+        deleteAllTexImg();
+        if (win) glfwDestroyWindow(win);
+        else headlessGL.destroy();
+        return written ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
     //////////////////////////
@@ -222,7 +335,7 @@ int main() {
 
     // Window size //
     glfwSetWindowSizeCallback(win, [](GLFWwindow* window, int width, int height) {
-        scene *sceneObjects = (scene *) glfwGetWindowUserPointer(window);
+        scene<appConfig> *sceneObjects = (scene<appConfig> *) glfwGetWindowUserPointer(window);
         // Keeps the window at a 1:1 width:height ratio
         printMessageTime();
         std::cout << "Window size change detected, adjusting viewport\n";
@@ -235,34 +348,40 @@ int main() {
         } else {
             glViewport(0, 0, height, height);
         }
-        sceneObjects->adjustPositions(width, height);
+        // The scene itself is moved on the simulation thread. A replay uses the recorded sizes
+        if (!replaying) {
+            sceneObjects->requestResize(width, height);
+        }
+        frames.requestRedraw();
         
     });
 
+    // Window contents lost, e.g. after being uncovered //
+    glfwSetWindowRefreshCallback(win, [](GLFWwindow *window) {
+        frames.requestRedraw();
+    });
+
     // Key presses //
-    // A for left, D for right, Space to jump, Tab to toggle vignette, Esc to close program
+    // A for left, D for right, Space to jump, Tab to toggle vignette, F3 to toggle the HUD, Esc to close program
     // F to toggle between maximised and minimised window. The affect of these presses
     // is governed by the scene object
     glfwSetKeyCallback(win, [](GLFWwindow *win, int key, int scancode, int action, int mods) {
 
         // Grabs the window scene
-        scene *sceneObjects = (scene *) glfwGetWindowUserPointer(win);
-
-        // Enables and disables if key is pressed
-        if (action == GLFW_RELEASE) {
-            sceneObjects->isKeyPressed[key] = false;
-        } else if (action == GLFW_PRESS || action == GLFW_REPEAT) {
-            if (key != GLFW_KEY_F && key != GLFW_KEY_ESCAPE && !gameState) {
-                // Enables gameState if any key is pressed besides F or Esc
-                gameState = true;
-            }
-            sceneObjects->isKeyPressed[key] = true;
+        scene<appConfig> *sceneObjects = (scene<appConfig> *) glfwGetWindowUserPointer(win);
+        if (replaying) return;
+
+        // Enables gameState if any key is pressed besides F or Esc
+        if (action == GLFW_PRESS && key != GLFW_KEY_F && key != GLFW_KEY_ESCAPE && !gameState) {
+            gameState = true;
         }
+        // Queues the press or release with when it happened, to be applied at the start of the next tick
+        sceneObjects->input.push(key, action, glfwGetTime());
 
     });
 
     // If screen saver mode is enabled, make the program full screen and detect for any mouse movements
-    if (SCREENSAVER_MODE) {
+    if (appConfig::SCREENSAVER_MODE) {
         // Sets to full screen mode
         GLFWmonitor *winMonitor = glfwGetPrimaryMonitor();
         const GLFWvidmode* vidMode = glfwGetVideoMode(winMonitor);
@@ -271,7 +390,7 @@ int main() {
         // Detects if cursor moves, then close program
         glfwSetCursorPosCallback(win, [](GLFWwindow *win,  double xPos, double yPos) {
 
-            if (initialMousePosX == UNDEF_MOUSE_POS || initialMousePosY == UNDEF_MOUSE_POS) {
+            if (initialMousePosX == appConfig::UNDEF_MOUSE_POS || initialMousePosY == appConfig::UNDEF_MOUSE_POS) {
                 initialMousePosY = yPos; // initialMousePosX is a global variable
                 initialMousePosX = xPos; // initialMousePosY is a global variable
             } else if (initialMousePosX != xPos || initialMousePosY != yPos){
@@ -292,59 +411,186 @@ int main() {
     // While loop to control renders and animation //
     /////////////////////////////////////////////////
 
-    // Gets the transform uniform location
-    GLint transformLoc = glGetUniformLocation(renderProgram, "transform");
-    chicken3421::expect(transformLoc != -1, "Unknown uniform variable name");
-
     // Variables to manage when to animate a frame for each scene object
     using namespace std::chrono;
-    std::list<shapeObject> shapeList;     // List which will contain the shapes to be drawn
-    std::list<shapeObject>::iterator obj; // An iterator of the above list
+    // Passes the draws of each tick over to the render loop. Sized for every draw a tick can have
+    snapshotBuffer snapshots(scene<appConfig>::MAX_DRAWS);
+
+    // Watches the frame times and renders into a smaller target when the machine is struggling
+    qualityGovernor<appConfig> governor;
+    lowResTarget lowResFrame;
+    GLint viewport[4];
+
+    // The frame rate and flake count, laid out again every frame it is shown
+    textBatch hud;
+    hud.setup(appConfig::HUD_MAX_GLYPHS);
+    char hudLine[appConfig::HUD_MAX_GLYPHS + 1];
+    int hudFps = 0, hudFrames = 0;
+    steady_clock::time_point hudSecondStart = steady_clock::now();
+
+    // Publishes the pre-warmed scene so there is something to draw straight away
+    sceneObjects.fillSnapshot(snapshots.back());
+    snapshots.publish();
+
+    // Handed from the render loop to the simulation, which applies it at the start of a tick
+    std::atomic<int> governorFlakeBudget{appConfig::FLAKE_TOTAL};
+    std::atomic<long> lastTick{0};
+
+    // THE SIMULATION THREAD TICKS THE SCENE AT A FIXED RATE AND PUBLISHES A SNAPSHOT EACH TICK
+    std::atomic<bool> simRunning{true};
+    std::thread simThread([&] {
+        long tickNo = 0;
+        bool started = false;
+        // Press time carried over from snapshots that were replaced before being drawn
+        double carriedInput = -1;
+        steady_clock::time_point nextTick = steady_clock::now();
+
+        while (simRunning) {
+            tickNo++;
+
+            // Everything from outside the simulation is applied here, either from the
+            // recording or from the window. Recordings store it against this tick
+            int width, height;
+            ALLOC_SCOPE(ALLOC_INPUT);
+            if (replaying) {
+                if (replayer.isFinished(tickNo)) {
+                    replayer.printSummary(tickNo - 1);
+                    sceneObjects.quitRequested = true;
+                    break;
+                }
+                while (const recordEntry *entry = replayer.nextBeforeTick(tickNo)) {
+                    switch (entry->type) {
+                        case REC_KEY:
+                            sceneObjects.input.inject((inputAction)entry->action, entry->a, glfwGetTime());
+                            break;
+                        case REC_RESIZE:
+                            sceneObjects.requestResize(entry->a, entry->b);
+                            break;
+                        case REC_GAME_START:
+                            gameState = true;
+                            break;
+                        case REC_FLAKE_BUDGET:
+                            sceneObjects.flakeBudget = entry->a;
+                            break;
+                    }
+                }
+            } else if (governorFlakeBudget != sceneObjects.flakeBudget) {
+                sceneObjects.flakeBudget = governorFlakeBudget;
+                recorder.add(tickNo, REC_FLAKE_BUDGET, 0, sceneObjects.flakeBudget);
+            }
+            if (sceneObjects.takeResize(width, height)) {
+                recorder.add(tickNo, REC_RESIZE, 0, width, height);
+                sceneObjects.adjustPositions(width, height);
+            }
 
-    // Time related variables
-    long startLoop = time_point_cast<milliseconds>(system_clock::now()).time_since_epoch().count();
-    long endLoop = 0, deltaTime = TICKS_TO_SECOND;
-    int autoSkipTimer = AUTO_SKIP_TIME;
+            // gameState is read once so the whole tick sees the same value
+            bool tickGameState = gameState;
+            if (tickGameState && !started) {
+                started = true;
+                recorder.add(tickNo, REC_GAME_START);
+            }
 
-    // CONTROLS THE ANIMATION AND THE TIMING OF WHAT IS DISPLAYED AND RENDERED
-    while (!glfwWindowShouldClose(win)) {
-        
-        if (!gameState && autoSkipTimer == 0) {
-            gameState = true;
-            printMessageTime();
-            std::cout << "Auto-skipped main menu\n";
+            // Inputs are applied before the tick so they affect this tick rather than the next one
+            sceneObjects.checkKeyInputs();
+            for (const inputEvent &event : sceneObjects.input.appliedEvents()) {
+                recorder.add(tickNo, REC_KEY, event.action, event.pressed);
+            }
+            {
+                ALLOC_SCOPE(ALLOC_TICK);
+                sceneObjects.tickAll(tickGameState);
+                if (sceneObjects.takeAutoSkip() && !gameState) {
+                    gameState = true;
+                    printMessageTime();
+                    std::cout << "Auto-skipped main menu\n";
+                }
+
+                if (recorder.isOpen()) {
+                    recorder.add(tickNo, REC_CHECKSUM, 0, sceneObjects.checksum());
+                } else if (replaying) {
+                    replayer.checkTick(tickNo, sceneObjects.checksum());
+                }
+            }
+
+            ALLOC_SCOPE(ALLOC_SNAPSHOT);
+            renderSnapshot &snapshot = snapshots.back();
+            sceneObjects.fillSnapshot(snapshot);
+            snapshot.tick = tickNo;
+            double applied = sceneObjects.input.takeOldestApplied();
+            if (applied >= 0 && (carriedInput < 0 || applied < carriedInput)) {
+                carriedInput = applied;
+            }
+            snapshot.inputTime = carriedInput;
+            if (!snapshots.publish()) {
+                carriedInput = -1;
+            }
+            frames.notifyTick();
+            lastTick = tickNo;
+
+            // Waits for the next tick. Skips a few ticks if the system is struggling
+            nextTick += milliseconds(appConfig::TICKS_TO_SECOND);
+            steady_clock::time_point now = steady_clock::now();
+            if (now - nextTick > milliseconds(3 * appConfig::TICKS_TO_SECOND)) {
+                nextTick = now;
+            }
+            std::this_thread::sleep_until(nextTick);
         }
+    });
 
-        glUseProgram(renderProgram);
-        glfwPollEvents();
-        glClear(GL_COLOR_BUFFER_BIT);
-        glClearColor(0, 0, 0, 1);
+    // Frame times of the run, to compare runs of the same recording
+    std::ofstream frameTimes;
+    if (!frameTimesPath.empty()) {
+        frameTimes.open(frameTimesPath);
+        chicken3421::expect((bool)frameTimes, "Could not write " + frameTimesPath);
+        frameTimes << "tick,cpu_ms\n";
+    }
 
-        // When deltaTime exceeds TICKS_TO_SECOND, calculate the transformations of each scene object
-        // for the next frame
-        if (deltaTime >= TICKS_TO_SECOND) {
-            if (!gameState && autoSkipTimer > 0) {
-                autoSkipTimer -= 1;
-            }
-            deltaTime -= TICKS_TO_SECOND;
-            sceneObjects.tickAll(gameState);
-            sceneObjects.checkKeyInputs(win);
+    stage.lap("callbacks and simulation thread", STARTUP_STAGE);
+
+    // Allocations counted by --alloc-check
+    long frameNo = 0;
+    allocCounts allocBaseline, allocSteadyState;
+
+    // THE RENDER LOOP DRAWS THE LATEST SNAPSHOT, WITHOUT WAITING FOR THE SIMULATION.
+    // IT SLEEPS BETWEEN TICKS AND ONLY DRAWS WHEN SOMETHING CHANGED
+    while (!glfwWindowShouldClose(win)) {
+        ALLOC_SCOPE(ALLOC_RENDER);
+
+        // Sleeps until there is a new tick or a window event instead of spinning
+        {
+            ALLOC_SCOPE(ALLOC_EVENTS);
+            frames.waitForWork();
+            sceneObjects.handleWindowRequests(win);
         }
+        bool newSnapshot = snapshots.acquire();
+        if (!frames.shouldPresent(newSnapshot)) continue;
 
-        // Draw all objects in the sceneObjects list
-        shapeList = sceneObjects.getAllObjects();
+        steady_clock::time_point frameStart = steady_clock::now();
+        governor.beginFrame();
 
-        for (obj = shapeList.begin(); obj != shapeList.end(); obj++) {
-            // Renders the shape that the iterator is pointing at
-            glBindVertexArray(obj->vao);
-            glBindBuffer(GL_ARRAY_BUFFER, obj->vbo);
-            glBindTexture(GL_TEXTURE_2D, obj->textureID);
-            // Applies the transformations onto the matrices
-            glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(obj->trans * obj->rot * obj->scale));
+        glUseProgram(renderProgram);
+        governorFlakeBudget = governor.getFlakeBudget();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glClearColor(0, 0, 0, 1);
 
-            glDrawArrays(GL_TRIANGLES, 0, obj->vertices.size());
+        // Redirects the scene into the low resolution target if the governor asks for it
+        float renderScale = governor.getRenderScale();
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        if (renderScale < 1) {
+            lowResFrame.resize(viewport[2] * renderScale, viewport[3] * renderScale);
+            glBindFramebuffer(GL_FRAMEBUFFER, lowResFrame.fbo);
+            glViewport(0, 0, lowResFrame.width, lowResFrame.height);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         }
-        shapeList.clear();
+
+        // Draw everything in the newest snapshot. If the window asked for a redraw without
+        // a tick having finished, the previous snapshot is drawn again
+        const renderSnapshot &snapshot = snapshots.front();
+        // Only the pixels that changed since the last frame of the menu animation are uploaded
+        sceneObjects.mainMenuObj.menuAnimation.showFrame(snapshot.menuFrame);
+        sceneObjects.sceneryTextures.update();
+        sceneObjects.chunks.update(snapshot.chunkEpoch);
+        renderer.draw(snapshot);
+        memTracker.recordTransient(snapshot.draws.capacity() * sizeof(drawRecord) + 2 * snapshot.order.capacity() * sizeof(sortEntry));
 
         // Resets vertex arrays and buffers
         glBindVertexArray(0);
@@ -352,26 +598,97 @@ int main() {
         glBindTexture(GL_TEXTURE_2D, 0);
         glUseProgram(0);
 
-        glfwSwapBuffers(win);
+        // Scales the low resolution frame up onto the window
+        if (renderScale < 1) {
+            lowResFrame.blitTo(viewport);
+            glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        }
 
-        // Calculates the time elapsed between start and end of loop and adds it
-        // to the deltaTime.
-        endLoop = time_point_cast<milliseconds>(system_clock::now()).time_since_epoch().count();
-        deltaTime += endLoop - startLoop;
-        // Caps deltaTime at 3 times TICKS_TO_SECOND to skip a few frames if the system is struggling
-        deltaTime %= 3 * TICKS_TO_SECOND;
-        startLoop = endLoop;
+        // The HUD goes over the scaled up frame so it stays sharp
+        hudFrames++;
+        if (frameStart - hudSecondStart >= seconds(1)) {
+            hudFps = hudFrames;
+            hudFrames = 0;
+            hudSecondStart = frameStart;
+        }
+        if (snapshot.showHud) {
+            snprintf(hudLine, sizeof(hudLine), "FPS %d\nFLAKES %d", hudFps, snapshot.activeFlakes);
+            hud.clear();
+            hud.add(hudLine, TEXT_HUD, glm::vec2(-0.97, 0.97), appConfig::HUD_PIXEL);
+            glUseProgram(renderProgram);
+            hud.draw(renderer);
+            glUseProgram(0);
+        }
+        float cpuMs = duration<float, std::milli>(steady_clock::now() - frameStart).count();
+        governor.endFrame(cpuMs);
+        if (frameTimes.is_open()) {
+            frameTimes << snapshot.tick << "," << cpuMs << "\n";
+        }
+
+        {
+            ALLOC_SCOPE(ALLOC_PRESENT);
+            glfwSwapBuffers(win);
+        }
+        if (newSnapshot) {
+            sceneObjects.input.markPresented(snapshot.inputTime, glfwGetTime());
+        }
+        if (startupProfile.isRecording()) {
+            reportStartup("first frame");
+        }
+
+        // Counts only the frames after the warm up, once everything has grown to its full size
+        frameNo++;
+        if (allocCheckFrames > 0 && frameNo == appConfig::ALLOC_WARMUP_FRAMES) {
+            allocBaseline = readAllocCounts();
+        } else if (allocCheckFrames > 0 && frameNo == appConfig::ALLOC_WARMUP_FRAMES + allocCheckFrames) {
+            allocSteadyState = readAllocCounts() - allocBaseline;
+            glfwSetWindowShouldClose(win, GLFW_TRUE);
+        }
+    }
+
+    // Stops the simulation before anything it uses is torn down
+    simRunning = false;
+    simThread.join();
+    recorder.close(lastTick);
+    if (!saveStatePath.empty()) {
+        std::ofstream stateFile(saveStatePath, std::ios::binary);
+        if (saveSceneState(stateFile, sceneObjects, gameState)) {
+            printMessageTime();
+            std::cout << "Saved scene state to " << saveStatePath << "\n";
+        } else {
+            std::cerr << "Could not save scene state to " << saveStatePath << "\n";
+        }
     }
 
     // Tearing down program once closed
     printMessageTime();
-    std::cout << "Closing program\n";
+    std::cout << "Closing program. Memory in use (KiB):\n";
+    memTracker.printReport();
+    sceneObjects.input.printLatencyReport();
+    frames.printReport();
+    governor.deleteSelf();
+    lowResFrame.deleteSelf();
+    hud.deleteSelf();
     glfwDestroyWindow(win);
     chicken3421::delete_program(renderProgram);
-    chicken3421::delete_shader(fragShader);
-    chicken3421::delete_shader(vertShader);
     sceneObjects.deleteAllShapes();
+    meshes.deleteAll();
     deleteAllTexImg();
 
+    if (allocCheckFrames > 0) {
+        printMessageTime();
+        if (frameNo < appConfig::ALLOC_WARMUP_FRAMES + allocCheckFrames) {
+            std::cout << "Allocation check failed: closed after " << frameNo << " frames\n";
+            return EXIT_FAILURE;
+        }
+        if (allocSteadyState.totalAllocations() > 0) {
+            std::cout << "Allocation check failed: " << allocSteadyState.totalAllocations() << " allocations in "
+                      << allocCheckFrames << " frames after warm up\n";
+            allocSteadyState.printReport();
+            return EXIT_FAILURE;
+        }
+        std::cout << "Allocation check passed: no allocations in " << allocCheckFrames << " frames after warm up\n";
+    }
+
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -11,45 +11,140 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
-// Required external variables
-extern const int SCREEN_HEIGHT;
-extern const int SCREEN_WIDTH;
-extern const float SPLASH_AMPLITUDE;
-extern const float SPLASH_POS_X;
-extern const float SPLASH_POS_Y;
-extern const float SPLASH_ROT;
-extern const float SPLASH_SCALE;
-extern const int AUTO_SKIP_TIME;
-extern const int MAIN_MENU_TIMER;
-extern const int MAX_FRAMES_MENU;
-extern const int TOTAL_SPL_TEX;
+#include <string>
+#include <vector>
+
+// What the splash text can say, one picked at random each run. Lines are split on '\n'
+const char *SPLASH_TEXTS[] = {
+    "UNOFFICIAL!",
+    "FAN-MADE",
+    "POWERED BY\nQUARANTINE BOREDOM",
+    "MAY CONTAIN TRACES\nOF SPAGHETTI CODE",
+    "A BIG\nWASTE OF TIME",
+    "CHICKEN!",
+    "UNENDORSED",
+    "GOTY 2021??",
+    "ALL GLITCHES\nARE INTENTIONAL",
+    "MADE\nWITH LAST MINUTE\nSWEAT AND TEARS!",
+    "HD WHEN?",
+    "MADE OF\nTRIANGLES",
+    "3090s NOT INCLUDED",
+    "LIKE THE REAL DEAL!",
+    "0% GOATS!",
+    "A SOCIAL EXPERIMENT",
+    "99.999% GLUTEN FREE",
+    "FIRST, DISCOMBOBULATE",
+};
+const int SPLASH_TEXT_COUNT = sizeof(SPLASH_TEXTS) / sizeof(SPLASH_TEXTS[0]);
+
+/**
+ * A single texture that plays a flipbook. Moving to the next frame only uploads the
+ * pixels that changed. Only used by the render thread, apart from reading texture
+ */
+struct flipbookTexture {
+    flipbook book;
+    GLuint texture = 0;
+    int currentFrame = 0;
+
+    /**
+     * Creates the texture showing the first frame
+     */
+    void setup(flipbook &&newBook, memSubsystem subsystem) {
+        book = std::move(newBook);
+        texture = uploadTexture(GL_RGBA8, GL_RGBA, book.width, book.height, book.keyframe.data());
+        memTracker.trackTexture(texture, subsystem, book.width, book.height, 4);
+        memTracker.addCpu(subsystem, book.keyframe.size() + book.changedBytes());
+        currentFrame = 0;
+    }
+
+    int frameCount() {
+        return book.frames.size();
+    }
+
+    /**
+     * Brings the texture up to the given frame. The next frame only needs its changes
+     * uploaded, any other frame starts again from the keyframe
+     */
+    void showFrame(int frame) {
+        if (frame == currentFrame || book.frames.empty()) return;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        if (frame != (currentFrame + 1) % frameCount()) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, book.width, book.height, GL_RGBA, GL_UNSIGNED_BYTE, book.keyframe.data());
+            currentFrame = 0;
+        }
+        while (currentFrame != frame) {
+            currentFrame = (currentFrame + 1) % frameCount();
+            const flipbookFrame &change = book.frames[currentFrame];
+            if (change.rect.width == 0) continue;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, change.rect.x, change.rect.y, change.rect.width, change.rect.height,
+                            GL_RGBA, GL_UNSIGNED_BYTE, change.pixels.data());
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+};
 
 /**
  * Contains all things related to the main menu
  */
+template <typename Config>
 struct mainMenuScene {
     shapeObject mainMenu, splashText, zID;
-    double menuScrollDist = 0, mainMenuTimer = MAIN_MENU_TIMER;
-    float sceneWidth = SCREEN_WIDTH, sceneHeight = SCREEN_HEIGHT; 
-    GLuint (*menuAnimationFrames) = new GLuint[MAX_FRAMES_MENU];
+    double menuScrollDist = 0;
+    // Cleared by the scene's timers once the menu has scrolled off
+    bool menuVisible = true;
+    float sceneWidth = Config::SCREEN_WIDTH, sceneHeight = Config::SCREEN_HEIGHT; 
+    flipbookTexture menuAnimation;
     int menuCurrFrame = 0;
 
     /**
      * Sets up all the textures needed for the main menu
      */
     void setupMenu() {
-        // Uses textures from the mainMenu folder. If texture is not found,
-        // default to the first frame's texture
-        for (int i = 0; i < MAX_FRAMES_MENU; i++) {
-            try {
-                menuAnimationFrames[i] = makeTexture(appendRdmNum("res/img/mainMenu/mainmenu_", i + 1, i + 1));
-            } catch (std::runtime_error) {
-                menuAnimationFrames[i] = menuAnimationFrames[0];
+        // Uses the flipbook made by ass1_assettool. If there is none, makes one from the
+        // frames in the mainMenu folder, stopping at the first frame that is not found
+        startupTimer timer;
+        flipbook book;
+        const std::string flipPath = "res/img/mainMenu/mainmenu.flip";
+        if (readFlipbook(flipPath, book)) {
+            timer.lap(flipPath, STARTUP_DECODE, book.fileBytes);
+        } else {
+            std::vector<chicken3421::image_t> frames;
+            std::vector<const unsigned char *> framePixels;
+            for (int i = 0; i < Config::MAX_FRAMES_MENU; i++) {
+                std::string framePath = "res/img/mainMenu/mainmenu_" + std::to_string(i + 1) + ".png";
+                long long fileBytes;
+                try {
+                    frames.push_back(loadImage(framePath, fileBytes));
+                } catch (std::runtime_error) {
+                    timer.lap("missing " + framePath, STARTUP_DECODE);
+                    break;
+                }
+                framePixels.push_back((unsigned char *)frames.back().data);
+                timer.lap(framePath, STARTUP_DECODE, fileBytes);
             }
+            chicken3421::expect(!frames.empty(), "Could not find the main menu frames");
+            makeFlipbook(framePixels, frames[0].width, frames[0].height, frames[0].n_channels, book);
+            for (chicken3421::image_t &frame : frames) chicken3421::delete_image(frame);
+            timer.lap("main menu flipbook", STARTUP_DECODE);
         }
-        // Grabs a random splash text texture from the corresponding folder
-        splashText.textureID = makeTexture(appendRdmNum("res/img/mainMenu/splashText/splash_", 1, TOTAL_SPL_TEX));
-        zID.textureID = makeTexture("res/img/mainMenu/zid.png");
+        menuAnimation.setup(std::move(book), MEM_MENU_FRAMES);
+        timer.lap(flipPath, STARTUP_UPLOAD);
+        zID.textureID = makeTexture("res/img/mainMenu/zid.png", MEM_MENU_FRAMES);
+    }
+
+    /**
+     * Saves or restores the menu through a stateStream
+     */
+    template <typename Stream>
+    void transferState(Stream &stream) {
+        stream.shape(mainMenu);
+        stream.shape(splashText);
+        stream.shape(zID);
+        stream.field(menuScrollDist);
+        stream.field(menuVisible);
+        stream.field(sceneWidth);
+        stream.field(sceneHeight);
+        stream.field(menuCurrFrame);
     }
 
     /**
@@ -63,13 +158,12 @@ struct mainMenuScene {
         mainMenu.resetTransforms();
         zID.resetTransforms();
         if (gameState) {
-            menuScrollDist -= SCROLL_SPEED;
+            menuScrollDist -= Config::SCROLL_SPEED;
             
             mainMenu.trans = glm::translate(mainMenu.trans, glm::vec3(menuScrollDist, 0.0, 0.0));
             zID.trans = glm::translate(zID.trans, glm::vec3(menuScrollDist, 0.0, 0.0));
-            mainMenuTimer--;
         }
-        mainMenu.textureID = menuAnimationFrames[menuCurrFrame];
+        mainMenu.textureID = menuAnimation.texture;
 
         // Scales the main menu according to the entire scene sclae
         float multiplier = 1;
@@ -80,14 +174,23 @@ struct mainMenuScene {
         zID.trans = glm::translate(zID.trans, glm::vec3(0, abs((sceneHeight - sceneWidth) / sceneWidth), 0.0));
 
         // Splash text animation modelled with a sin curve
-        float newScale = 1 + glm::sin((M_PI * menuCurrFrame) / 20) * SPLASH_AMPLITUDE;
+        float newScale = 1 + glm::sin((M_PI * menuCurrFrame) / 20) * Config::SPLASH_AMPLITUDE;
         resetSplashText();
         splashText.scale = glm::scale(splashText.scale, glm::vec3(newScale, newScale, 0.0));
         splashText.trans = glm::translate(splashText.trans, glm::vec3(menuScrollDist, 0.0, 0.0));
 
         menuCurrFrame++;
-        menuCurrFrame %= MAX_FRAMES_MENU;
+        menuCurrFrame %= Config::MAX_FRAMES_MENU;
+
+    }
 
+    /**
+     * The flipbook frame the last tick showed. The animation holds its first frame for
+     * the rest of the loop once it runs out of frames
+     */
+    int shownFrame() {
+        int frame = (menuCurrFrame + Config::MAX_FRAMES_MENU - 1) % Config::MAX_FRAMES_MENU;
+        return frame < menuAnimation.frameCount() ? frame : 0;
     }
 
     /**
@@ -97,10 +200,10 @@ struct mainMenuScene {
     void resetSplashText() {
         float sceneScale = sceneHeight / sceneWidth;
         splashText.resetTransforms();
-        splashText.scale = glm::scale(splashText.scale, glm::vec3(SPLASH_SCALE, SPLASH_SCALE, 0.0));
+        splashText.scale = glm::scale(splashText.scale, glm::vec3(Config::SPLASH_SCALE, Config::SPLASH_SCALE, 0.0));
         splashText.scale = glm::scale(splashText.scale, glm::vec3(sceneScale, sceneScale, 0.0));
-        splashText.rot = glm::rotate(splashText.rot, glm::radians(SPLASH_ROT), glm::vec3(0.0, 0.0, 1.0));
-        splashText.trans = glm::translate(splashText.trans, glm::vec3(SPLASH_POS_X * sceneScale, SPLASH_POS_Y * sceneScale, 0.0));
+        splashText.rot = glm::rotate(splashText.rot, glm::radians(Config::SPLASH_ROT), glm::vec3(0.0, 0.0, 1.0));
+        splashText.trans = glm::translate(splashText.trans, glm::vec3(Config::SPLASH_POS_X * sceneScale, Config::SPLASH_POS_Y * sceneScale, 0.0));
     }
 
     /**
@@ -123,6 +226,5 @@ struct mainMenuScene {
     void deleteShapes() {
         mainMenu.deleteSelf();
         splashText.deleteSelf();
-        delete[] menuAnimationFrames;
     }
 };
\ No newline at end of file
@@ -0,0 +1,148 @@
+/**
+ * File contains the memoryTracker struct, which keeps count of how many bytes each
+ * part of the program is using on the CPU and the GPU
+ */
+
+#include <glad/glad.h>
+
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+/**
+ * The parts of the program that memory is counted against
+ */
+enum memSubsystem {
+    MEM_MENU_FRAMES,
+    MEM_GOAT_FRAMES,
+    MEM_SCENERY_TEXTURES,
+    MEM_OTHER_TEXTURES,
+    MEM_SNOWFLAKE_SHAPES,
+    MEM_SHAPE_BUFFERS,
+    MEM_CPU_IMAGES,
+    MEM_RENDER_TARGETS,
+    MEM_FRAME_TRANSIENT,
+    MEM_TOTAL_SUBSYSTEMS
+};
+
+const char *MEM_SUBSYSTEM_NAMES[MEM_TOTAL_SUBSYSTEMS] = {
+    "Menu frames",
+    "Goat frames",
+    "Foreground/parallax textures",
+    "Other textures",
+    "Snowflake shapes",
+    "Shape buffers",
+    "Decoded CPU images",
+    "Render targets",
+    "Per-frame transient",
+};
+
+/**
+ * Keeps a running count of bytes per subsystem as resources are created and freed.
+ * GPU sizes are estimates worked out from the format and dimensions of each resource
+ */
+struct memoryTracker {
+private:
+    long long cpuBytes[MEM_TOTAL_SUBSYSTEMS] = {};
+    long long gpuBytes[MEM_TOTAL_SUBSYSTEMS] = {};
+    long long peakBytes[MEM_TOTAL_SUBSYSTEMS] = {};
+
+    /**
+     * Contains what a single GL object was counted as, so it can be taken away again
+     */
+    struct trackedObject {
+        memSubsystem subsystem;
+        long long cpuBytes;
+        long long gpuBytes;
+    };
+    std::map<GLuint, trackedObject> textures;
+    std::map<GLuint, trackedObject> buffers;
+
+public:
+    /**
+     * Counts CPU memory against a subsystem. Use a negative amount when it is freed
+     */
+    void addCpu(memSubsystem subsystem, long long bytes) {
+        cpuBytes[subsystem] += bytes;
+        updatePeak(subsystem);
+    }
+
+    /**
+     * Counts a texture against a subsystem
+     * @param bytesPerTexel estimated size of a single texel in the texture's internal format
+     */
+    void trackTexture(GLuint tex, memSubsystem subsystem, int width, int height, int bytesPerTexel) {
+        long long bytes = (long long)width * height * bytesPerTexel;
+        untrackTexture(tex);
+        textures[tex] = {subsystem, 0, bytes};
+        gpuBytes[subsystem] += bytes;
+        updatePeak(subsystem);
+    }
+
+    void untrackTexture(GLuint tex) {
+        auto found = textures.find(tex);
+        if (found == textures.end()) return;
+        gpuBytes[found->second.subsystem] -= found->second.gpuBytes;
+        textures.erase(found);
+    }
+
+    /**
+     * Counts a vertex buffer against a subsystem, along with any CPU copy of its data
+     */
+    void trackBuffer(GLuint buffer, memSubsystem subsystem, long long bufferBytes, long long copyBytes) {
+        untrackBuffer(buffer);
+        buffers[buffer] = {subsystem, copyBytes, bufferBytes};
+        gpuBytes[subsystem] += bufferBytes;
+        cpuBytes[subsystem] += copyBytes;
+        updatePeak(subsystem);
+    }
+
+    void untrackBuffer(GLuint buffer) {
+        auto found = buffers.find(buffer);
+        if (found == buffers.end()) return;
+        gpuBytes[found->second.subsystem] -= found->second.gpuBytes;
+        cpuBytes[found->second.subsystem] -= found->second.cpuBytes;
+        buffers.erase(found);
+    }
+
+    /**
+     * Records how much was allocated while building the current frame. Only the
+     * latest frame and the peak are kept
+     */
+    void recordTransient(long long bytes) {
+        cpuBytes[MEM_FRAME_TRANSIENT] = bytes;
+        updatePeak(MEM_FRAME_TRANSIENT);
+    }
+
+    /**
+     * Prints a table of the current and peak bytes of every subsystem, in KiB
+     */
+    void printReport() {
+        std::cout << std::left << std::setw(32) << "  Subsystem" << std::right
+                  << std::setw(12) << "CPU" << std::setw(12) << "GPU" << std::setw(12) << "Peak" << "\n";
+
+        long long totalCpu = 0, totalGpu = 0;
+        for (int i = 0; i < MEM_TOTAL_SUBSYSTEMS; i++) {
+            std::cout << std::left << std::setw(32) << (std::string("  ") + MEM_SUBSYSTEM_NAMES[i]) << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(12) << cpuBytes[i] / 1024.0
+                      << std::setw(12) << gpuBytes[i] / 1024.0
+                      << std::setw(12) << peakBytes[i] / 1024.0 << "\n";
+            totalCpu += cpuBytes[i];
+            totalGpu += gpuBytes[i];
+        }
+        std::cout << std::left << std::setw(32) << "  Total" << std::right
+                  << std::setw(12) << totalCpu / 1024.0 << std::setw(12) << totalGpu / 1024.0 << "\n";
+        std::cout << std::defaultfloat;
+    }
+
+private:
+    void updatePeak(memSubsystem subsystem) {
+        long long current = cpuBytes[subsystem] + gpuBytes[subsystem];
+        if (current > peakBytes[subsystem]) {
+            peakBytes[subsystem] = current;
+        }
+    }
+};
+
+// Keeps track of the memory used by everything in the program
+memoryTracker memTracker;
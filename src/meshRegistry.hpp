@@ -0,0 +1,162 @@
+/**
+ * File contains meshRegistry, which keeps a single copy on the GPU of every distinct mesh.
+ * Shapes with the same vertices share one vertex array, and vertices are packed into
+ * 8 bytes each. Nothing of a mesh is kept on the CPU apart from what is needed to tell
+ * it apart from other meshes
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Size of one step of a packed position and texture co-ordinate. Must match vert.glsl.
+// Positions reach +-32 and texture co-ordinates 0 to 32, which covers the ground's repeats
+const float POSITION_STEP = 1.0f / 1024;
+const float UV_STEP = 1.0f / 2048;
+
+/**
+ * A vertex as it is stored on the GPU. z is always 0 and w always 1, so only x and y
+ * are kept. Co-ordinates are fixed point, in POSITION_STEP and UV_STEP units
+ */
+struct packedVert {
+    int16_t x, y;
+    uint16_t u, v;
+};
+
+/**
+ * A mesh on the GPU, and how many shapes are using it
+ */
+struct meshEntry {
+    GLuint vao;
+    GLuint vbo;
+    GLsizei vertexCount;
+    glm::vec2 boundsMin, boundsMax;
+    std::vector<packedVert> packed; // Kept to compare against meshes with the same hash
+    int users;
+};
+
+/**
+ * Hands out shared meshes. A mesh is deleted once every shape using it has been deleted
+ */
+struct meshRegistry {
+private:
+    // Meshes by the hash of their packed vertices. Different meshes can share a hash
+    std::unordered_multimap<uint32_t, meshEntry> entries;
+
+public:
+    /**
+     * Packs a vertex, checking it fits in the packed format
+     */
+    static packedVert pack(const vert &v) {
+        float x = std::round(v.vertexCoords.x / POSITION_STEP), y = std::round(v.vertexCoords.y / POSITION_STEP);
+        float u = std::round(v.textureCoords.x / UV_STEP), tv = std::round(v.textureCoords.y / UV_STEP);
+        chicken3421::expect(x >= INT16_MIN && x <= INT16_MAX && y >= INT16_MIN && y <= INT16_MAX, "Vertex position out of range");
+        chicken3421::expect(u >= 0 && u <= UINT16_MAX && tv >= 0 && tv <= UINT16_MAX, "Texture co-ordinate out of range");
+        return {(int16_t)x, (int16_t)y, (uint16_t)u, (uint16_t)tv};
+    }
+
+    /**
+     * Finds the mesh with the given vertices, uploading it if there is none yet
+     * @param memSubsystem what the mesh's buffer is counted against if it is new
+     * @return const meshEntry& the shared mesh
+     */
+    const meshEntry &acquire(const std::vector<vert> &vertices, memSubsystem subsystem) {
+        std::vector<packedVert> packed;
+        for (const vert &v : vertices) {
+            packed.push_back(pack(v));
+        }
+        uint32_t hash = hashBytes(2166136261u, packed.data(), packed.size() * sizeof(packedVert));
+
+        auto range = entries.equal_range(hash);
+        for (auto found = range.first; found != range.second; found++) {
+            meshEntry &mesh = found->second;
+            if (mesh.packed.size() == packed.size() && memcmp(mesh.packed.data(), packed.data(), packed.size() * sizeof(packedVert)) == 0) {
+                mesh.users++;
+                return mesh;
+            }
+        }
+
+        meshEntry mesh;
+        mesh.vertexCount = packed.size();
+        mesh.users = 1;
+
+        // Works out the extent of the mesh so shapes can be culled when they are off screen
+        mesh.boundsMin = mesh.boundsMax = glm::vec2(packed[0].x * POSITION_STEP, packed[0].y * POSITION_STEP);
+        for (const packedVert &v : packed) {
+            mesh.boundsMin = glm::vec2(std::min(mesh.boundsMin.x, v.x * POSITION_STEP), std::min(mesh.boundsMin.y, v.y * POSITION_STEP));
+            mesh.boundsMax = glm::vec2(std::max(mesh.boundsMax.x, v.x * POSITION_STEP), std::max(mesh.boundsMax.y, v.y * POSITION_STEP));
+        }
+
+        glGenVertexArrays(1, &mesh.vao);
+        glGenBuffers(1, &mesh.vbo);
+        glBindVertexArray(mesh.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+        glBufferData(GL_ARRAY_BUFFER, (GLintptr)(sizeof(packedVert) * packed.size()), packed.data(), GL_STATIC_DRAW);
+        memTracker.trackBuffer(mesh.vbo, subsystem, sizeof(packedVert) * packed.size(), sizeof(packedVert) * packed.size());
+
+        // Integers are converted to floats as they are, and scaled by the step in the shader
+        glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, sizeof(packedVert), (void *)offsetof(packedVert, x));
+        glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(packedVert), (void *)offsetof(packedVert, u));
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        mesh.packed = std::move(packed);
+        return entries.emplace(hash, std::move(mesh))->second;
+    }
+
+    /**
+     * Stops a shape using the mesh with the given vertex array. Deletes the mesh if
+     * nothing else uses it
+     */
+    void release(GLuint vao) {
+        for (auto found = entries.begin(); found != entries.end(); found++) {
+            meshEntry &mesh = found->second;
+            if (mesh.vao != vao) continue;
+            if (--mesh.users == 0) {
+                deleteMesh(mesh);
+                entries.erase(found);
+            }
+            return;
+        }
+    }
+
+    /**
+     * How many distinct meshes are on the GPU
+     */
+    size_t size() {
+        return entries.size();
+    }
+
+    /**
+     * Deletes every mesh, including ones shapes are still using
+     */
+    void deleteAll() {
+        for (auto &found : entries) {
+            deleteMesh(found.second);
+        }
+        entries.clear();
+    }
+
+private:
+    void deleteMesh(meshEntry &mesh) {
+        memTracker.untrackBuffer(mesh.vbo);
+        glDeleteBuffers(1, &mesh.vbo);
+        glDeleteVertexArrays(1, &mesh.vao);
+    }
+};
+
+// Every mesh the program has made
+meshRegistry meshes;
@@ -0,0 +1,138 @@
+/**
+ * File contains palettisedImage, an image stored as 8-bit indices into a palette of
+ * at most 256 colours, along with functions to make one from an RGB(A) image and to
+ * read/write it in the .ipal format. Does not depend on OpenGL so the asset tool can use it
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// .ipal file layout: magic, version, width, height, palette size, palette (RGBA), indices
+const char IPAL_MAGIC[4] = {'I', 'P', 'A', 'L'};
+const uint32_t IPAL_VERSION = 1;
+const int MAX_PALETTE_SIZE = 256;
+// Largest width or height a .ipal file can have. Anything larger is taken to be a damaged file
+const uint32_t MAX_IPAL_SIDE = 16384;
+
+/**
+ * Contains an image as one index per pixel and the RGBA colours the indices refer to
+ */
+struct palettisedImage {
+    int width = 0;
+    int height = 0;
+    int paletteSize = 0;
+    std::vector<unsigned char> palette;  // paletteSize * 4 bytes of RGBA
+    std::vector<unsigned char> indices;  // width * height bytes
+    long long fileBytes = 0;             // Size of the .ipal file it was read from, 0 if it was made in memory
+};
+
+/**
+ * Converts an image into a palettised one. Only succeeds if the image has at most
+ * MAX_PALETTE_SIZE distinct colours, so the conversion is always lossless
+ * @param data pixels of the image, row by row
+ * @param channels 3 for RGB, 4 for RGBA
+ * @return bool whether the image fit in a palette
+ */
+bool palettiseImage(const unsigned char *data, int width, int height, int channels, palettisedImage &result) {
+    std::unordered_map<uint32_t, unsigned char> colourIndex;
+    result.width = width;
+    result.height = height;
+    result.palette.clear();
+    result.indices.resize((size_t)width * height);
+
+    for (size_t i = 0; i < result.indices.size(); i++) {
+        const unsigned char *pixel = data + i * channels;
+        unsigned char alpha = (channels == 4) ? pixel[3] : 255;
+        uint32_t colour = pixel[0] | (pixel[1] << 8) | (pixel[2] << 16) | ((uint32_t)alpha << 24);
+
+        auto found = colourIndex.find(colour);
+        if (found == colourIndex.end()) {
+            if ((int)colourIndex.size() == MAX_PALETTE_SIZE) {
+                // Too many colours to be stored losslessly
+                return false;
+            }
+            found = colourIndex.emplace(colour, (unsigned char)colourIndex.size()).first;
+            result.palette.insert(result.palette.end(), {pixel[0], pixel[1], pixel[2], alpha});
+        }
+        result.indices[i] = found->second;
+    }
+    result.paletteSize = colourIndex.size();
+    return true;
+}
+
+/**
+ * Works out where the .ipal version of an image is kept, which is next to the original
+ */
+std::string palettisedPath(const std::string &fileName) {
+    size_t extension = fileName.rfind('.');
+    return fileName.substr(0, extension) + ".ipal";
+}
+
+/**
+ * Writes a palettised image into a .ipal file
+ * @return bool whether the file was written
+ */
+bool writePalettisedImage(const std::string &fileName, const palettisedImage &img) {
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file) return false;
+    uint32_t header[4] = {IPAL_VERSION, (uint32_t)img.width, (uint32_t)img.height, (uint32_t)img.paletteSize};
+    file.write(IPAL_MAGIC, sizeof(IPAL_MAGIC));
+    file.write((const char *)header, sizeof(header));
+    file.write((const char *)img.palette.data(), img.palette.size());
+    file.write((const char *)img.indices.data(), img.indices.size());
+    return (bool)file;
+}
+
+/**
+ * Reads a .ipal file
+ * @return bool whether the file existed and was valid
+ */
+bool readPalettisedImage(const std::string &fileName, palettisedImage &img) {
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file) return false;
+
+    char magic[4];
+    uint32_t header[4];
+    file.read(magic, sizeof(magic));
+    file.read((char *)header, sizeof(header));
+    if (!file || memcmp(magic, IPAL_MAGIC, sizeof(magic)) != 0 || header[0] != IPAL_VERSION) return false;
+    if (header[3] == 0 || header[3] > (uint32_t)MAX_PALETTE_SIZE) return false;
+    if (header[1] == 0 || header[2] == 0 || header[1] > MAX_IPAL_SIDE || header[2] > MAX_IPAL_SIDE) return false;
+
+    // The palette and indices must be exactly what is left of the file, so a truncated or
+    // damaged file is never read short or allowed to ask for a huge allocation
+    std::streampos dataStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff remaining = file.tellg() - dataStart;
+    file.seekg(dataStart);
+    if (!file || remaining != (std::streamoff)header[3] * 4 + (std::streamoff)header[1] * header[2]) return false;
+    img.fileBytes = (long long)(dataStart + remaining);
+
+    img.width = header[1];
+    img.height = header[2];
+    img.paletteSize = header[3];
+    img.palette.resize(img.paletteSize * 4);
+    img.indices.resize((size_t)img.width * img.height);
+    file.read((char *)img.palette.data(), img.palette.size());
+    file.read((char *)img.indices.data(), img.indices.size());
+    return (bool)file;
+}
+
+/**
+ * Reads the .ipal version of an image, unless the image has been changed since it was made
+ * @return bool whether an up to date, valid .ipal file was read
+ */
+bool readCurrentPalettisedImage(const std::string &imageName, palettisedImage &img) {
+    std::error_code error;
+    std::filesystem::file_time_type indexedTime = std::filesystem::last_write_time(palettisedPath(imageName), error);
+    if (error) return false;
+    std::filesystem::file_time_type imageTime = std::filesystem::last_write_time(imageName, error);
+    // Edited art is loaded from the image until ass1_assettool is run again
+    if (!error && imageTime > indexedTime) return false;
+    return readPalettisedImage(palettisedPath(imageName), img);
+}
@@ -0,0 +1,173 @@
+/**
+ * File contains makeCachedProgram, which saves linked shader programs to disk with
+ * glGetProgramBinary so that later runs can load them instead of compiling and linking
+ * them again. A saved program is only used by the same driver with the same sources,
+ * otherwise the program is compiled as usual and the cache is replaced
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Program cache file layout: magic, version, hash of the shader sources, length of the
+// driver string followed by it, binary format, binary length followed by the binary
+const char PROGRAM_CACHE_MAGIC[4] = {'P', 'B', 'I', 'N'};
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+/**
+ * Reads a whole text file
+ * @return std::string the file's contents, empty if it could not be read
+ */
+std::string readTextFile(const std::string &fileName) {
+    std::ifstream file(fileName);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+/**
+ * Identifies the driver a program binary was made by. Binaries only load on the driver
+ * that made them
+ */
+std::string programDriverString() {
+    std::string driver;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const GLubyte *value = glGetString(name);
+        driver += value ? (const char *)value : "";
+        driver += '\n';
+    }
+    return driver;
+}
+
+/**
+ * Loads a program from a cache file, if it was saved by this driver from these sources
+ * @return GLuint the linked program, or 0 if the cache could not be used
+ */
+GLuint loadProgramBinary(const std::string &cachePath, uint32_t sourceHash, const std::string &driver) {
+    std::ifstream file(cachePath, std::ios::binary);
+    if (!file) return 0;
+
+    char magic[4];
+    uint32_t header[3];
+    file.read(magic, sizeof(magic));
+    file.read((char *)header, sizeof(header));
+    if (!file || memcmp(magic, PROGRAM_CACHE_MAGIC, sizeof(magic)) != 0) return 0;
+    if (header[0] != PROGRAM_CACHE_VERSION || header[1] != sourceHash || header[2] != driver.size()) return 0;
+    std::string savedDriver(driver.size(), '\0');
+    file.read(&savedDriver[0], savedDriver.size());
+    if (savedDriver != driver) return 0;
+
+    uint32_t binary[2];
+    file.read((char *)binary, sizeof(binary));
+    if (!file) return 0;
+    // A damaged file could give any length, so it must fit in what is left of the file
+    std::streampos dataStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff remaining = file.tellg() - dataStart;
+    file.seekg(dataStart);
+    if (!file || binary[1] == 0 || (std::streamoff)binary[1] > remaining) return 0;
+    std::vector<char> data(binary[1]);
+    file.read(data.data(), data.size());
+    if (!file) return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, binary[0], data.data(), data.size());
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // The driver was updated without changing its strings
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+/**
+ * Saves a linked program into a cache file
+ * @return bool whether the driver gave a binary and it was written
+ */
+bool saveProgramBinary(const std::string &cachePath, GLuint program, uint32_t sourceHash, const std::string &driver) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return false;
+    std::vector<char> data(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, data.data());
+
+    std::ofstream file(cachePath, std::ios::binary);
+    uint32_t header[3] = {PROGRAM_CACHE_VERSION, sourceHash, (uint32_t)driver.size()};
+    uint32_t binary[2] = {format, (uint32_t)length};
+    file.write(PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC));
+    file.write((const char *)header, sizeof(header));
+    file.write(driver.data(), driver.size());
+    file.write((const char *)binary, sizeof(binary));
+    file.write(data.data(), length);
+    return (bool)file;
+}
+
+/**
+ * Makes a program from a vertex and a fragment shader, loading it from the cache file if
+ * it can and compiling it and saving it into the cache file otherwise. Prints whether the
+ * cache was used and how long it took
+ * @return GLuint the linked program. Its shaders are already deleted
+ */
+GLuint makeCachedProgram(const std::string &vertPath, const std::string &fragPath, const std::string &cachePath) {
+    using namespace std::chrono;
+    steady_clock::time_point start = steady_clock::now();
+
+    std::string vertSource = readTextFile(vertPath), fragSource = readTextFile(fragPath);
+    uint32_t sourceHash = hashBytes(2166136261u, vertSource.data(), vertSource.size());
+    sourceHash = hashBytes(sourceHash, fragSource.data(), fragSource.size());
+    std::string driver = programDriverString();
+
+    // Drivers without any binary formats can not save programs
+    GLint binaryFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+
+    GLuint program = (binaryFormats > 0) ? loadProgramBinary(cachePath, sourceHash, driver) : 0;
+    bool cacheHit = program != 0;
+    if (!cacheHit) {
+        GLuint vertShader = chicken3421::make_shader(vertPath, GL_VERTEX_SHADER);
+        GLuint fragShader = chicken3421::make_shader(fragPath, GL_FRAGMENT_SHADER);
+        program = glCreateProgram();
+        glAttachShader(program, vertShader);
+        glAttachShader(program, fragShader);
+        // Asks the driver to keep the binary around so it can be saved
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            char log[1024];
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            chicken3421::expect(false, std::string("Could not link shader program: ") + log);
+        }
+        glDetachShader(program, vertShader);
+        glDetachShader(program, fragShader);
+        chicken3421::delete_shader(vertShader);
+        chicken3421::delete_shader(fragShader);
+
+        if (binaryFormats > 0 && !saveProgramBinary(cachePath, program, sourceHash, driver)) {
+            printMessageTime();
+            std::cout << "Could not write shader program cache " << cachePath << "\n";
+        }
+    }
+
+    printMessageTime();
+    std::cout << (cacheHit ? "Loaded shader program from cache" : "Compiled shader program (cache miss)")
+              << " in " << duration<double, std::milli>(steady_clock::now() - start).count() << " ms\n";
+    return program;
+}
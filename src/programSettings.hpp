@@ -0,0 +1,134 @@
+/**
+ * File contains every setting of the program. Settings are grouped into profiles, and
+ * the structs that need them take the profile as a template parameter so every value
+ * is known at compile time. The application is built once per profile
+ */
+
+//////////////////////
+// PROGRAM SETTINGS //
+//////////////////////
+
+/**
+ * The settings of the regular, interactive program
+ */
+struct interactiveProfile {
+    // Application window settings:
+    static constexpr const char *APP_TITLE =  "COMP3421 21T3 Assignment 1 [Minecraft: Goat Simulator]";
+    static constexpr int   SCREEN_WIDTH       = 900;   // Screen width of the program
+    static constexpr int   SCREEN_HEIGHT      = 900;   // Screen height of the program
+    static constexpr bool  SCREENSAVER_MODE   = false; // Whether to compile this program as a screensaver or not
+    static constexpr int   UNDEF_MOUSE_POS    = -1;    // The value to represent an undefined mouse position
+    static constexpr bool  VSYNC              = true;  // Whether to wait for the display before presenting a frame
+
+    // Main menu settings
+    static constexpr int   MAIN_MENU_TIMER    = 300;   // How log the main menu lasts on the window
+    static constexpr int   MAX_FRAMES_MENU    = 119;   // How long the main menu animation lasts for (Must be a multiple of two - 1)
+    static constexpr int   AUTO_SKIP_TIME     = 2800;  // How long until the animation automatically starts (2.8k = 1 minute)
+    static constexpr float SPLASH_WIDTH       = 1.9;   // Widest the splash text is laid out, before it is scaled
+    static constexpr float SPLASH_PIXEL       = 0.032; // Largest size of a pixel of the splash text's font, before it is scaled
+    static constexpr float SPLASH_SCALE       = 0.30;  // Scale of splash text
+    static constexpr float SPLASH_ROT         = 12.5f; // How much the splash text is askewed
+    static constexpr float SPLASH_POS_X       = 0.69;  // X position of splash text
+    static constexpr float SPLASH_POS_Y       = 0.55;  // Y position of splash text
+    static constexpr float SPLASH_AMPLITUDE   = 0.07;  // How violent the splash text bobs
+
+    // HUD settings:
+    static constexpr bool  SHOW_HUD           = false; // Whether the frame rate and flake count are shown from the start (F3 toggles it)
+    static constexpr float HUD_PIXEL          = 0.006; // Size of a pixel of the HUD's font
+    static constexpr int   HUD_MAX_GLYPHS     = 64;    // Most characters the HUD can show at once
+
+    // Speed of animation:
+    static constexpr int   TICKS_TO_SECOND    = 20;    // Lower value = faster; Higher value = slower;
+
+    // Ground settings:
+    static constexpr float SCROLL_SPEED       = 0.01;  // How fast the objects scroll by the screen
+    static constexpr float GROUND_POS_Y       = -0.8;  // Y position of the ground
+    static constexpr float GROUND_SCALE       = 0.2;   // Dimension size of ground
+    static constexpr int   GROUND_TILES       = 20;    // How many tiles are in the shape
+
+    // Background object settings:
+    static constexpr int   FG_TIMER           = 500;   // How long foreground objects last on the screen
+    static constexpr int   PARALLAX_TIMER     = 4;     // How long background objects last = PARALLAX_TIMER * FG_TIMER
+    static constexpr float FG_POS_Y           = 0.9;   // Y position of the foreground objects
+    static constexpr float FG_SCALE           = 1.5;   // Size of foreground objects
+    static constexpr float PARALLAX_POS_Y     = 0.4;   // Y position of background objects
+    static constexpr float PARALLAX_POS_X     = 2.0;   // X position of background objects
+    static constexpr int   MAX_FRAMES_SKY     = 2;     // How many frames the night sky has
+    static constexpr float MOON_SCALE         = 0.2;   // Size of the Moon
+    static constexpr float MOON_POS_XY        = 0.6;   // X and Y position of the Moon
+    static constexpr int   TOTAL_MOON_TEX     = 8;     // Total possible Moon phases
+
+    // Goat settings:
+    static constexpr int   ANIM_FRAME_LEN     = 4;     // The length of the frames of the Goat's animation
+    static constexpr int   AIRBORNE_LEN_MAX   = 15;    // Total time the Goat is in the air
+    static constexpr int   MAX_FRAMES_GOAT    = 8;     // Total frames of the Goat's animation
+    static constexpr float GOAT_POS_Y         = -0.275;// Y position of Goat
+    static constexpr float GOAT_SCALE         = 0.4;   // Scale of the Goat
+    static constexpr float GOAT_JUMP_ROT      = 5.0f;  // How many degrees the Goat rotates in its jump
+    static constexpr float GOAT_WALK_SPEED    = 0.01;  // How far the Goat moves when "D" is pressed
+    static constexpr int   GOAT_WALK_RANGE    = 1;     // How far from the centre of the screen the Goat can move to
+
+    // Snow flake settings
+    static constexpr int   TOTAL_SF_TEX       = 4;     // How many possible textures a snowflake can be
+    static constexpr int   FLAKE_TOTAL        = 900;   // How many flakes are present. MUST BE AN EVEN NUMBER
+    static constexpr int   FLAKE_TIMER        = 1600;  // How long the flakes last on the screen
+    static constexpr float FLAKE_ROT_SPEED    = 5.0f;  // How many degrees the flakes rotate
+    static constexpr int   FLAKE_CHANCE       = 2;     // The chance a snow flake spawns every tick (1 / FLAKE_CHANCE)
+    static constexpr float FLAKE_SCALE        = 0.03;  // How big the flake is
+    static constexpr float FLAKE_POS_Y        = 1.02;  // X position of where the flakes spawn
+    static constexpr float W_AMPLITUDE        = 0.01;  // Wind's amplitude, controls how crazy the wind is
+    static constexpr int   W_COEFFICIENT      = 8;     // Controls how short each wind bursts are. Has pi as the numerator
+    static constexpr float W_VERT_SHIFT       = 0.005; // Controls how effective each wind bursts are
+
+    // Background and Parallax Settings:
+    static constexpr int   BG_SPAWN_CHANCE    = 400;   // The chance of background spawning (1 / BG_SPAWN_CHANCE)
+    static constexpr int   TOTAL_FG_TEX       = 12;    // The total amount of possible foreground textures
+    static constexpr int   TOTAL_P_TEX        = 4;     // The total amount of possible parallax textures
+    static constexpr float TREE_LOOP_POS_Y    = 0.4;   // Y position of the looping trees in the background
+
+    // Scenery chunk settings:
+    static constexpr float CHUNK_WIDTH        = 2.0;   // Width of each chunk of foreground scenery (a screen's width)
+    static constexpr int   CHUNK_PROPS        = 3;     // Most props placed in a chunk
+    static constexpr int   CHUNK_MIN_PROPS    = 1;     // Fewest props placed in a chunk
+    static constexpr float CHUNK_MIN_SCALE    = 0.7;   // Smallest a prop can be, as a fraction of FG_SCALE
+    static constexpr int   CHUNK_AHEAD        = 4;     // How many chunks are kept laid out, starting with the one at the left of the screen
+    static constexpr int   CHUNK_POOL         = 6;     // How many chunk buffers there are. MUST BE MORE THAN CHUNK_AHEAD
+
+    // Scrolling layer settings (texture repeats scrolled per unit the scene scrolls):
+    static constexpr float GROUND_PARALLAX    = 1 / (2 * GROUND_SCALE); // Ground moves with the scene
+    static constexpr float TREE_LOOP_PARALLAX = 0.05;  // Tree loop moves at a tenth of the scene's speed
+    static constexpr float CLOUD_PARALLAX     = 0.01;  // Clouds drift slower than everything else
+    static constexpr float SCROLL_WRAP        = 1000;  // Scroll distance wraps here. Must be a whole number of repeats for every layer
+
+    // Texture settings:
+    static constexpr bool  PALETTE_TEXTURES   = true;  // Whether images with 256 colours or less are stored as 8-bit index textures
+    static constexpr int   SCENERY_TEX_BUDGET = 4 << 20; // Bytes of scenery textures kept on the GPU before the least recently used are evicted
+
+    // Quality governor settings:
+    static constexpr bool  ADAPTIVE_QUALITY   = true;  // Whether to lower the quality when frames take too long
+    static constexpr float TARGET_FRAME_MS    = 20;    // Frame time budget in milliseconds (one frame per tick)
+    static constexpr float QUALITY_UP_RATIO   = 0.6;   // Quality is restored once frames average below this fraction of the budget
+    static constexpr int   QUALITY_WINDOW     = 60;    // How many recent frames are averaged
+    static constexpr int   QUALITY_COOLDOWN   = 120;   // How many frames must pass inbetween quality changes
+
+    // Startup profiler settings:
+    static constexpr int   STARTUP_SLOWEST    = 10;    // How many of the slowest assets --startup-profile lists
+
+    // Allocation check settings:
+    static constexpr int   ALLOC_WARMUP_FRAMES = 300;  // Frames to let everything reach its full size before allocations are counted
+};
+
+/**
+ * The settings of the screensaver build. Same as the interactive program, but goes
+ * full screen and closes on mouse movement
+ */
+struct screensaverProfile : interactiveProfile {
+    static constexpr bool  SCREENSAVER_MODE   = true;  // Whether to compile this program as a screensaver or not
+};
+
+// The profile this build of the application uses
+#ifdef ASS1_SCREENSAVER_PROFILE
+using appConfig = screensaverProfile;
+#else
+using appConfig = interactiveProfile;
+#endif
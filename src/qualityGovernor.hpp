@@ -0,0 +1,203 @@
+/**
+ * File contains the qualityGovernor struct, which watches recent frame times and lowers
+ * the render resolution and snowflake budget when the machine cannot keep up
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <array>
+#include <iostream>
+
+// Each quality level, from best to worst. Render scale is relative to the viewport
+const int QUALITY_LEVELS = 4;
+const float QUALITY_RENDER_SCALE[QUALITY_LEVELS] = {1.0, 0.75, 0.5, 0.35};
+const float QUALITY_FLAKE_SCALE[QUALITY_LEVELS] = {1.0, 0.65, 0.4, 0.2};
+
+/**
+ * Offscreen colour and depth target the scene is drawn into when rendering below the
+ * viewport's resolution. It is upscaled onto the window with GL_NEAREST
+ */
+struct lowResTarget {
+    GLuint fbo = 0;
+    GLuint colourTex = 0;
+    GLuint depthBuffer = 0;
+    int width = 0, height = 0;
+
+    /**
+     * Makes sure the target exists and has the given dimensions
+     */
+    void resize(int newWidth, int newHeight) {
+        if (fbo != 0 && newWidth == width && newHeight == height) return;
+        width = newWidth;
+        height = newHeight;
+
+        if (fbo == 0) {
+            glGenFramebuffers(1, &fbo);
+            glGenTextures(1, &colourTex);
+            glGenRenderbuffers(1, &depthBuffer);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, colourTex);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        // Have filter to be GL_NEAREST so the upscale keeps the pixel art crisp
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        // Counted along with the depth buffer, which drivers store in 4 bytes per pixel
+        memTracker.trackTexture(colourTex, MEM_RENDER_TARGETS, width, height, 4 + 4);
+
+        // The depth is only used while drawing, so it never needs to be a texture
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colourTex, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        chicken3421::expect(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Low resolution framebuffer is incomplete");
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    /**
+     * Copies the target onto the given rectangle of the window, scaling it up
+     */
+    void blitTo(const GLint viewport[4]) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(
+            0, 0, width, height,
+            viewport[0], viewport[1], viewport[0] + viewport[2], viewport[1] + viewport[3],
+            GL_COLOR_BUFFER_BIT, GL_NEAREST
+        );
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void deleteSelf() {
+        memTracker.untrackTexture(colourTex);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &colourTex);
+        glDeleteRenderbuffers(1, &depthBuffer);
+        fbo = 0;
+        colourTex = 0;
+        depthBuffer = 0;
+    }
+};
+
+/**
+ * Keeps a rolling window of frame costs and picks a quality level from them.
+ * The cost of a frame is the larger of the CPU time spent building it and the
+ * GPU time spent drawing it, so waiting on vsync does not count as being slow
+ */
+template <typename Config>
+struct qualityGovernor {
+private:
+    int level = 0;
+    int framesSinceChange = 0;
+
+    // Rolling window of the most recent frame costs
+    std::array<float, Config::QUALITY_WINDOW> frameCosts;
+    int costIndex = 0;
+    int costCount = 0;
+    float costSum = 0;
+
+    // GPU timer queries. A few are kept in flight so reading one back never stalls
+    static const int TOTAL_QUERIES = 3;
+    GLuint gpuQueries[TOTAL_QUERIES];
+    bool queryPending[TOTAL_QUERIES] = {false, false, false};
+    int currQuery = 0;
+    float lastGpuMs = 0;
+
+public:
+    qualityGovernor() {
+        glGenQueries(TOTAL_QUERIES, gpuQueries);
+    }
+
+    /**
+     * Starts timing the GPU work of the current frame
+     */
+    void beginFrame() {
+        // Reads back the oldest query if the GPU has finished with it
+        if (queryPending[currQuery]) {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(gpuQueries[currQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 elapsedNs = 0;
+                glGetQueryObjectui64v(gpuQueries[currQuery], GL_QUERY_RESULT, &elapsedNs);
+                lastGpuMs = elapsedNs / 1.0e6;
+            }
+            queryPending[currQuery] = false;
+        }
+        glBeginQuery(GL_TIME_ELAPSED, gpuQueries[currQuery]);
+    }
+
+    /**
+     * Stops timing the GPU work and records the frame's cost
+     * @param cpuMs how long the CPU took to build the frame, excluding the buffer swap
+     */
+    void endFrame(float cpuMs) {
+        glEndQuery(GL_TIME_ELAPSED);
+        queryPending[currQuery] = true;
+        currQuery = (currQuery + 1) % TOTAL_QUERIES;
+
+        float cost = (cpuMs > lastGpuMs) ? cpuMs : lastGpuMs;
+        if (costCount == Config::QUALITY_WINDOW) {
+            costSum -= frameCosts[costIndex];
+        } else {
+            costCount++;
+        }
+        frameCosts[costIndex] = cost;
+        costSum += cost;
+        costIndex = (costIndex + 1) % Config::QUALITY_WINDOW;
+
+        framesSinceChange++;
+        if (Config::ADAPTIVE_QUALITY && costCount == Config::QUALITY_WINDOW && framesSinceChange >= Config::QUALITY_COOLDOWN) {
+            float average = costSum / costCount;
+            if (average > Config::TARGET_FRAME_MS && level < QUALITY_LEVELS - 1) {
+                changeLevel(level + 1, average);
+            } else if (average < Config::TARGET_FRAME_MS * Config::QUALITY_UP_RATIO && level > 0) {
+                // Only restores quality once there is plenty of headroom, so that
+                // the governor does not flip back and forth around the target
+                changeLevel(level - 1, average);
+            }
+        }
+    }
+
+    /**
+     * Getter for the fraction of the viewport's resolution to render at
+     */
+    float getRenderScale() {
+        return QUALITY_RENDER_SCALE[level];
+    }
+
+    /**
+     * Getter for how many snowflakes may be alive at once
+     */
+    int getFlakeBudget() {
+        return Config::FLAKE_TOTAL * QUALITY_FLAKE_SCALE[level];
+    }
+
+    void deleteSelf() {
+        glDeleteQueries(TOTAL_QUERIES, gpuQueries);
+    }
+
+private:
+    /**
+     * Moves to a new quality level and starts a fresh measurement window
+     */
+    void changeLevel(int newLevel, float average) {
+        printMessageTime();
+        std::cout << "Average frame cost " << average << "ms, quality level set to " << newLevel << "\n";
+        level = newLevel;
+        framesSinceChange = 0;
+        costCount = 0;
+        costSum = 0;
+        costIndex = 0;
+    }
+};
@@ -0,0 +1,325 @@
+/**
+ * File contains renderSnapshot, the list of draws the simulation hands over to the
+ * render loop, and snapshotBuffer, the triple buffer the snapshots are passed through.
+ * Draws carry a sort key and are radix sorted so that draws sharing a texture end up
+ * next to each other without changing what ends up on top.
+ * Draws that need no blending go first, front to back, and a depth test keeps them in
+ * the painter's order while skipping the pixels they cover. Draws that need blending
+ * follow back to front, tested against that depth but not writing it
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * How a draw is combined with what is already on screen
+ */
+enum blendMode {
+    BLEND_OPAQUE,  // Covers everything behind it
+    BLEND_CUTOUT,  // Covers everything behind it, apart from transparent pixels which are discarded
+    BLEND_ALPHA    // Blended over what is behind it
+};
+
+// Depth between draws that follow each other. Each draw is placed in front of every draw
+// submitted before it, so the depth buffer can tell which one is on top. Allows 16383 draws
+const float DRAW_DEPTH_STEP = 1.0f / 8192;
+
+// Most draws merged into one instanced draw call. Must match the size of the transform
+// array in vert.glsl
+const int DRAW_BATCH_SIZE = 32;
+
+/**
+ * Picks how a draw is combined with what is already on screen from how much of its
+ * texture can be seen through
+ */
+blendMode blendModeOf(textureAlpha alpha) {
+    switch (alpha) {
+        case ALPHA_OPAQUE:
+            return BLEND_OPAQUE;
+        case ALPHA_BINARY:
+            return BLEND_CUTOUT;
+        default:
+            return BLEND_ALPHA;
+    }
+}
+
+/**
+ * Everything needed to draw a single shape, with its transformations already combined
+ */
+struct drawRecord {
+    GLuint vao;
+    GLuint textureID;
+    GLint firstVertex;  // 0 unless the buffer is shared by several draws
+    GLsizei vertexCount;
+    float uvParallax;
+    blendMode blend;
+    glm::mat4 transform;
+};
+
+/**
+ * Builds the key draws are sorted by. From most to least significant:
+ * blended or not (1 bit), layer (8 bits), blend mode (3 bits), texture (20 bits), depth (32 bits).
+ * Blended draws keep the painter's order of layers, and depth keeps the submission order
+ * of draws that share a layer and a texture. Draws that are not blended have their layer
+ * and depth reversed so they go front to back
+ */
+uint64_t makeSortKey(int layer, blendMode blend, GLuint texture, uint32_t depth) {
+    bool blended = blend == BLEND_ALPHA;
+    if (!blended) {
+        layer = 0xFF - layer;
+        depth = ~depth;
+    }
+    return ((uint64_t)blended << 63) | ((uint64_t)(layer & 0xFF) << 55) | ((uint64_t)(blend & 0x7) << 52)
+         | ((uint64_t)(texture & 0xFFFFF) << 32) | depth;
+}
+
+/**
+ * A sort key and the draw it belongs to. Sorting these is cheaper than moving the draws
+ */
+struct sortEntry {
+    uint64_t key;
+    uint32_t index;
+};
+
+/**
+ * Sorts entries by key, least significant byte first (LSD radix sort). Stable, so
+ * equal keys keep their order. Bytes that are the same in every key are skipped
+ * @param scratch used as the second buffer, resized as needed
+ */
+void radixSort(std::vector<sortEntry> &entries, std::vector<sortEntry> &scratch) {
+    scratch.resize(entries.size());
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {};
+        for (const sortEntry &entry : entries) {
+            counts[(entry.key >> shift) & 0xFF]++;
+        }
+        if (counts[(entries.empty() ? 0 : entries[0].key >> shift) & 0xFF] == entries.size()) {
+            // Every key has the same byte here, so this pass would not move anything
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t &count : counts) {
+            size_t bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+        for (const sortEntry &entry : entries) {
+            scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
+
+/**
+ * The draws making up one tick of the scene, in the order they are to be drawn
+ */
+struct renderSnapshot {
+    std::vector<drawRecord> draws;
+    // Indices into draws, in the order they are submitted
+    std::vector<sortEntry> order;
+    std::vector<sortEntry> sortScratch;
+    long tick = 0;
+    // sceneryChunks::epoch when this was filled, handed back to it when drawn
+    long chunkEpoch = 0;
+    // How far the scene has scrolled. Repeating layers offset their texture by this in the shader
+    float scroll = 0;
+    // Earliest key press applied in or before this tick that has not been shown yet, -1 if none
+    double inputTime = -1;
+    // Frame of the main menu's flipbook to show
+    int menuFrame = 0;
+    // Whether the HUD is drawn over the scene, and the flake count it shows
+    bool showHud = false;
+    int activeFlakes = 0;
+
+    void clear() {
+        draws.clear();
+        order.clear();
+    }
+
+    /**
+     * Adds a draw with the given layer and blend mode, in front of every draw added before it
+     */
+    void add(int layer, const drawRecord &draw) {
+        order.push_back({makeSortKey(layer, draw.blend, draw.textureID, (uint32_t)draws.size()), (uint32_t)draws.size()});
+        draws.push_back(draw);
+        // Shapes are flat, so the z translation is the depth the whole draw ends up at
+        draws.back().transform[3][2] = 1 - DRAW_DEPTH_STEP * draws.size();
+    }
+
+    /**
+     * Puts the draws into submission order
+     */
+    void sort() {
+        radixSort(order, sortScratch);
+    }
+};
+
+/**
+ * Passes snapshots from the simulation thread to the render thread without locking.
+ * The simulation writes into the back buffer and publishes it, the render loop picks
+ * up the latest published one. Neither side ever waits on the other
+ */
+struct snapshotBuffer {
+private:
+    // Set on the middle index when it holds a snapshot that has not been picked up yet
+    static constexpr int FRESH_BIT = 4;
+
+    renderSnapshot snapshots[3];
+    int backIndex = 0;
+    int frontIndex = 1;
+    std::atomic<int> middleIndex{2};
+
+public:
+    /**
+     * @param drawCapacity the most draws a snapshot can hold. Reserved up front so filling
+     * a snapshot never allocates
+     */
+    snapshotBuffer(size_t drawCapacity) {
+        for (renderSnapshot &snapshot : snapshots) {
+            snapshot.draws.reserve(drawCapacity);
+            snapshot.order.reserve(drawCapacity);
+            snapshot.sortScratch.reserve(drawCapacity);
+        }
+    }
+
+    /**
+     * The snapshot the simulation is writing into. Only used by the simulation thread
+     */
+    renderSnapshot &back() {
+        return snapshots[backIndex];
+    }
+
+    /**
+     * Hands the back buffer over to the render thread. Only used by the simulation thread
+     * @return bool true if the previous snapshot was replaced before it was ever drawn
+     */
+    bool publish() {
+        int previous = middleIndex.exchange(backIndex | FRESH_BIT, std::memory_order_acq_rel);
+        backIndex = previous & ~FRESH_BIT;
+        return previous & FRESH_BIT;
+    }
+
+    /**
+     * Swaps in the newest published snapshot if there is one. Only used by the render thread
+     * @return bool whether front() changed
+     */
+    bool acquire() {
+        if (!(middleIndex.load(std::memory_order_relaxed) & FRESH_BIT)) return false;
+        frontIndex = middleIndex.exchange(frontIndex, std::memory_order_acq_rel) & ~FRESH_BIT;
+        return true;
+    }
+
+    /**
+     * The snapshot the render thread is drawing. Only used by the render thread
+     */
+    const renderSnapshot &front() {
+        return snapshots[frontIndex];
+    }
+};
+
+/**
+ * Draws snapshots with the scene's shader program
+ */
+struct snapshotRenderer {
+    GLint transformLoc = -1;
+    GLint palettedLoc = -1;
+    GLint scrollLoc = -1;
+    GLint uvParallaxLoc = -1;
+    GLint alphaTestLoc = -1;
+
+    /**
+     * Gets the locations of the uniforms every draw sets
+     */
+    void setup(GLuint program) {
+        transformLoc = glGetUniformLocation(program, "transform");
+        chicken3421::expect(transformLoc != -1, "Unknown uniform variable name");
+        palettedLoc = glGetUniformLocation(program, "paletted");
+        chicken3421::expect(palettedLoc != -1, "Unknown uniform variable name");
+        scrollLoc = glGetUniformLocation(program, "scroll");
+        chicken3421::expect(scrollLoc != -1, "Unknown uniform variable name");
+        uvParallaxLoc = glGetUniformLocation(program, "uvParallax");
+        chicken3421::expect(uvParallaxLoc != -1, "Unknown uniform variable name");
+        alphaTestLoc = glGetUniformLocation(program, "alphaTest");
+        chicken3421::expect(alphaTestLoc != -1, "Unknown uniform variable name");
+    }
+
+    /**
+     * Whether two draws can be drawn as instances of the same call: the same vertices with
+     * the same texture and state, differing only in their transformation
+     */
+    static bool canBatch(const drawRecord &a, const drawRecord &b) {
+        return a.vao == b.vao && a.textureID == b.textureID && a.firstVertex == b.firstVertex &&
+               a.vertexCount == b.vertexCount && a.uvParallax == b.uvParallax && a.blend == b.blend;
+    }
+
+    /**
+     * Draws everything in a snapshot in its sorted order. Runs of draws that can be batched,
+     * such as the snowflakes sharing a texture, are merged into instanced draw calls. The
+     * program must already be in use and the depth buffer cleared
+     */
+    void draw(const renderSnapshot &snapshot) {
+        // Repeating layers scroll their textures in the vertex shader, so only their
+        // parallax factor changes between draws
+        glUniform1f(scrollLoc, snapshot.scroll);
+        float boundParallax = 0;
+        glUniform1f(uvParallaxLoc, boundParallax);
+        // Draws are sorted so runs share a texture, so state is only changed when it differs
+        GLuint boundVao = 0, boundTex = 0;
+        blendMode boundBlend = BLEND_ALPHA;
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+        glUniform1i(alphaTestLoc, false);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glm::mat4 batchTransforms[DRAW_BATCH_SIZE];
+        size_t next = 0;
+        while (next < snapshot.order.size()) {
+            const drawRecord &draw = snapshot.draws[snapshot.order[next].index];
+            if (draw.vao != boundVao) {
+                boundVao = draw.vao;
+                glBindVertexArray(boundVao);
+            }
+            if (draw.textureID != boundTex) {
+                boundTex = draw.textureID;
+                bindTexture(boundTex, palettedLoc);
+            }
+            if (draw.blend != boundBlend) {
+                boundBlend = draw.blend;
+                if (boundBlend == BLEND_ALPHA) glEnable(GL_BLEND);
+                else glDisable(GL_BLEND);
+                // Blended draws are drawn last, so nothing needs to be tested against them
+                glDepthMask(boundBlend != BLEND_ALPHA);
+                glUniform1i(alphaTestLoc, boundBlend == BLEND_CUTOUT);
+            }
+            if (draw.uvParallax != boundParallax) {
+                boundParallax = draw.uvParallax;
+                glUniform1f(uvParallaxLoc, boundParallax);
+            }
+            // Transformations were combined by the simulation thread. Each instance picks its
+            // own, and keeps its own depth, so the batch draws exactly what separate draws would
+            int instances = 0;
+            do {
+                batchTransforms[instances++] = snapshot.draws[snapshot.order[next++].index].transform;
+            } while (next < snapshot.order.size() && instances < DRAW_BATCH_SIZE &&
+                     canBatch(draw, snapshot.draws[snapshot.order[next].index]));
+            glUniformMatrix4fv(transformLoc, instances, GL_FALSE, glm::value_ptr(batchTransforms[0]));
+
+            glDrawArraysInstanced(GL_TRIANGLES, draw.firstVertex, draw.vertexCount, instances);
+        }
+        glDisable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_BLEND);
+    }
+};
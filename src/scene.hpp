@@ -1,6 +1,7 @@
 /**
  * File contains scene struct, which encompasses all shapes to be rendered in the program.
- * Struct also contains all the currently pressed keyboard keys
+ * Struct also contains the queue of keyboard inputs. The scene is ticked on the simulation
+ * thread, so anything the window thread asks of it goes through the atomics below
  */
 
 #include <glad/glad.h>
@@ -12,99 +13,138 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
+#include <array>
+#include <atomic>
 #include <iostream>
 
-// Required external variables
-extern const bool SCREENSAVER_MODE;
-extern const float FG_COOLDOWN;
-extern const float FG_POS_Y;
-extern const float FG_SCALE;
-extern const float FLAKE_POS_Y;
-extern const float FLAKE_SCALE;
-extern const float GROUND_POS_Y;
-extern const float GROUND_SCALE;
-extern const float MOON_POS_XY;
-extern const float MOON_SCALE;
-extern const float PARALLAX_POS_X;
-extern const float PARALLAX_POS_Y;
-extern const float TREE_LOOP_POS_Y;
-extern const float W_AMPLITUDE;
-extern const float W_VERT_SHIFT;
-extern const int BG_SPAWN_CHANCE;
-extern const int FG_TIMER;
-extern const int FLAKE_CHANCE;
-extern const int FLAKE_TIMER;
-extern const int FLAKE_TOTAL;
-extern const int MAX_FRAMES_SKY;
-extern const int PARALLAX_TIMER;
-extern const int SCREEN_HEIGHT;
-extern const int SCREEN_WIDTH;
-extern const int TOTAL_FG_TEX;
-extern const int TOTAL_KEYS;
-extern const int TOTAL_P_TEX;
-extern const int W_COEFFICIENT;
-
 bool enableOverlay = true;
 
+/**
+ * The layers of the scene, from the back to the front. Shapes within a layer may be
+ * drawn in any order, so only the snowflake halves and the props share one
+ */
+enum sceneLayer {
+    LAYER_SKY,
+    LAYER_MOON,
+    LAYER_CLOUDS,
+    LAYER_TREE_LOOP,
+    LAYER_PARALLAX,
+    LAYER_LOWER_FLAKES,
+    LAYER_PROPS,
+    LAYER_GOAT,
+    LAYER_UPPER_FLAKES,
+    LAYER_GROUND,
+    LAYER_OVERLAY,
+    LAYER_MENU,
+    LAYER_SPLASH,
+    LAYER_ZID
+};
+
+/**
+ * The scene's timers. Snowflake i uses TIMER_FIRST_FLAKE + i
+ */
+enum sceneTimer {
+    TIMER_PARALLAX,    // The background object has scrolled off
+    TIMER_MENU,        // The main menu has scrolled off
+    TIMER_AUTO_SKIP,   // The main menu has waited long enough for a key press
+    TIMER_FIRST_FLAKE  // A snowflake's life time has run out
+};
+
+/**
+ * The prop callback of scene::forEachVisible for callers that only want the shapes
+ */
+struct skipProps {
+    void operator()(GLuint, const chunkDraw &, const glm::mat4 &) const {}
+};
+
+/**
+ * Contains every shape in the program. All pools are sized by the settings profile
+ */
+template <typename Config>
 struct scene {
-    mainMenuScene mainMenuObj;
+    static_assert(Config::FLAKE_TOTAL % 2 == 0, "FLAKE_TOTAL must be an even number");
+
+    // Most draws a tick can have: the 11 other shapes, every snowflake and one per prop
+    // in every chunk that is kept laid out
+    static constexpr int MAX_DRAWS = 11 + Config::FLAKE_TOTAL + Config::CHUNK_AHEAD * Config::CHUNK_PROPS;
+
+    mainMenuScene<Config> mainMenuObj;
     shapeObject overlay, background;
     shapeObject moon;
     shapeObject clouds;
     shapeObject ground;
-    shapeObject foregroundObjA;
-    shapeObject foregroundObjB;
     shapeObject parallaxObj;
     shapeObject parallaxLoopObj;
-    snowFlakeObject (*snowFlakes) = new snowFlakeObject[FLAKE_TOTAL];
-    goatObject goat;
-    bool (*isKeyPressed) = new bool[TOTAL_KEYS];
+    std::array<snowFlakeObject<Config>, Config::FLAKE_TOTAL> snowFlakes;
+    goatObject<Config> goat;
+    inputQueue input;
+    // How many snowflakes may be alive at once. Set by the simulation loop from the quality governor
+    int flakeBudget = Config::FLAKE_TOTAL;
+    // Every countdown in the scene, see sceneTimer
+    timerWheel<TIMER_FIRST_FLAKE + Config::FLAKE_TOTAL> timers;
+    // Textures of the foreground and background objects. Only the ones that are on screen
+    // or were recently are kept on the GPU. The render loop must call update before drawing
+    textureResidency<Config> sceneryTextures;
+    // The props in front of the mountains, streamed in chunks as the scene scrolls. The
+    // render loop must call update before drawing
+    sceneryChunks<Config> chunks;
+
+    // Window actions asked for by key presses, carried out by the window thread
+    std::atomic<bool> quitRequested{false};
+    std::atomic<bool> fullscreenRequested{false};
+    std::atomic<bool> memoryReportRequested{false};
 
 private:
-    float translatedGroundPos = 0, translatedParallaxLoopPos = 0;
+    // Ticks the scene has scrolled for. Counted rather than adding up a float distance, so the
+    // ground and the props standing on it are always placed from the same exact position
+    long long scrolledTicks = 0;
+    // The scroll distance wraps after this many ticks
+    static constexpr long long SCROLL_WRAP_TICKS = (long long)(Config::SCROLL_WRAP / Config::SCROLL_SPEED + 0.5);
 
-    int fgObjATimer = FG_TIMER;
-    int fgObjBTimer = FG_TIMER;
-    int parallaxTimer = PARALLAX_TIMER * FG_TIMER;
-    bool fgObjASpawned = false;
-    bool fgObjBSpawned = false;
     bool pallxSpawned = false;
-    int coolDownTimer = 0;
+    // Set when TIMER_AUTO_SKIP runs out, until the simulation loop takes it. Never set
+    // between ticks, so it is not saved
+    bool autoSkipDue = false;
     float sinCurveX = 0;
+    int activeFlakes = 0;
+    // Whether the render loop draws the HUD. Only affects what is shown, so it is not saved
+    bool hudVisible = Config::SHOW_HUD;
+
+    // Latest window size, applied at the start of the next tick
+    std::atomic<bool> resizePending{false};
+    std::atomic<int> resizeWidth{0}, resizeHeight{0};
 
-    GLuint (*possibleTexID) = new GLuint[TOTAL_FG_TEX];
-    GLuint (*possibleParaTexID) = new GLuint[TOTAL_P_TEX];
-    GLuint skyAnimationFrames[2];
+    std::array<GLuint, Config::TOTAL_FG_TEX> possibleTexID;
+    std::array<GLuint, Config::TOTAL_P_TEX> possibleParaTexID;
+    std::array<GLuint, Config::MAX_FRAMES_SKY> skyAnimationFrames;
 
 public:
     scene() {
-        // Loading in all possible textures
-
-        possibleTexID[0] = makeTexture("res/img/treeATexture.png");
-        possibleTexID[1] = makeTexture("res/img/treeBTexture.png");
-        possibleTexID[2] = makeTexture("res/img/snowGolemATexture.png");
-        possibleTexID[3] = makeTexture("res/img/snowGolemBTexture.png");
-        possibleTexID[4] = makeTexture("res/img/mossyPileTexture.png");
-        possibleTexID[5] = makeTexture("res/img/berryBushesATexture.png");
-        possibleTexID[6] = makeTexture("res/img/berryBushesBTexture.png");
-        possibleTexID[7] = makeTexture("res/img/plainGrassATexture.png");
-        possibleTexID[8] = makeTexture("res/img/plainGrassBTexture.png");
-        possibleTexID[9] = makeTexture("res/img/ruinedPortalTexture.png");
-        possibleTexID[10] = makeTexture("res/img/iceSpikeATexture.png");
-        possibleTexID[11] = makeTexture("res/img/iceSpikeBTexture.png");
-
-        possibleParaTexID[0] = makeTexture("res/img/mountainAParallax.png");
-        possibleParaTexID[1] = makeTexture("res/img/mountainBParallax.png");
-        possibleParaTexID[2] = makeTexture("res/img/mountainCParallax.png");
-        possibleParaTexID[3] = makeTexture("res/img/mountainDParallax.png");
+        // Loading in all possible textures. Scenery is only loaded once it is spawned
+
+        possibleTexID[0] = sceneryTextures.add("res/img/treeATexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[1] = sceneryTextures.add("res/img/treeBTexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[2] = sceneryTextures.add("res/img/snowGolemATexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[3] = sceneryTextures.add("res/img/snowGolemBTexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[4] = sceneryTextures.add("res/img/mossyPileTexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[5] = sceneryTextures.add("res/img/berryBushesATexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[6] = sceneryTextures.add("res/img/berryBushesBTexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[7] = sceneryTextures.add("res/img/plainGrassATexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[8] = sceneryTextures.add("res/img/plainGrassBTexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[9] = sceneryTextures.add("res/img/ruinedPortalTexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[10] = sceneryTextures.add("res/img/iceSpikeATexture.png", MEM_SCENERY_TEXTURES);
+        possibleTexID[11] = sceneryTextures.add("res/img/iceSpikeBTexture.png", MEM_SCENERY_TEXTURES);
+
+        possibleParaTexID[0] = sceneryTextures.add("res/img/mountainAParallax.png", MEM_SCENERY_TEXTURES);
+        possibleParaTexID[1] = sceneryTextures.add("res/img/mountainBParallax.png", MEM_SCENERY_TEXTURES);
+        possibleParaTexID[2] = sceneryTextures.add("res/img/mountainCParallax.png", MEM_SCENERY_TEXTURES);
+        possibleParaTexID[3] = sceneryTextures.add("res/img/mountainDParallax.png", MEM_SCENERY_TEXTURES);
 
         skyAnimationFrames[0] = makeTexture("res/img/sky/nightSky_1.png");
         skyAnimationFrames[1] = makeTexture("res/img/sky/nightSky_2.png");
 
-        for (int i = 0; i < TOTAL_KEYS; i++) {
-            // Initialises all key presses to be false (aka not pressed down)
-            isKeyPressed[i] = false;
-        }
+        // Every run places the props differently, unless a saved scene is loaded
+        chunks.setup(sceneryTextures, possibleTexID.data(), Config::TOTAL_FG_TEX, (uint32_t)rdmInt());
     }
 
     /**
@@ -115,168 +155,243 @@ public:
         overlay.deleteSelf();
         background.deleteSelf();
         moon.deleteSelf();
-        foregroundObjA.deleteSelf();
-        foregroundObjB.deleteSelf();
         ground.deleteSelf();
+        chunks.deleteBuffers();
         parallaxObj.deleteSelf();
         goat.deleteSelf();
-        for (int i = 0; i < FLAKE_TOTAL; i++) {
+        for (int i = 0; i < Config::FLAKE_TOTAL; i++) {
             snowFlakes[i].snowFlakeShape.deleteSelf();
         }
-        delete[] snowFlakes;
-        delete[] isKeyPressed;
     }
 
     /**
-     * Returns every shape that needs to be rendered, picking from the shapes that are active
+     * Calls func with every shape that needs to be rendered, its combined transformation and
+     * its layer. Shapes are given in the order they are drawn, and shapes on a higher layer
+     * are always drawn over lower ones. Shapes that are entirely off screen are skipped.
+     * propFunc is called with the vertex array, draw and transformation of every group of
+     * props on screen, at their place in the order on LAYER_PROPS
      */
-    std::list<shapeObject> getAllObjects() {
-        std::list<shapeObject> returnList;
-        returnList.emplace_back(background);
-        returnList.emplace_back(moon);
-        returnList.emplace_back(clouds);
-        returnList.emplace_back(parallaxLoopObj);
+    template <typename Func, typename PropFunc = skipProps>
+    void forEachVisible(Func func, PropFunc propFunc = PropFunc()) {
+        auto submit = [&](const shapeObject &shape, sceneLayer layer) {
+            glm::mat4 model = shape.trans * shape.rot * shape.scale;
+            if (shape.isOnScreen(model)) {
+                func(shape, model, layer);
+            }
+        };
+        submit(background, LAYER_SKY);
+        submit(moon, LAYER_MOON);
+        submit(clouds, LAYER_CLOUDS);
+        submit(parallaxLoopObj, LAYER_TREE_LOOP);
         if (pallxSpawned) {
-            returnList.emplace_back(parallaxObj);
+            submit(parallaxObj, LAYER_PARALLAX);
         }
-        for (int i = 0; i < FLAKE_TOTAL / 2; i++) {
+        for (int i = 0; i < Config::FLAKE_TOTAL / 2; i++) {
             // Places first half at a lower layer on the list so it appears beneath shapes
             if (snowFlakes[i].isActive) {
-                returnList.emplace_back(snowFlakes[i].snowFlakeShape);
+                submit(snowFlakes[i].snowFlakeShape, LAYER_LOWER_FLAKES);
             }
         }
-        if (fgObjASpawned) {
-            returnList.emplace_back(foregroundObjA);
-        }
-        if (fgObjBSpawned) {
-            returnList.emplace_back(foregroundObjB);
-        }
-        returnList.emplace_back(goat.goatShape);
-        for (int i = FLAKE_TOTAL / 2; i < FLAKE_TOTAL; i++) {
+        chunks.forEachVisible(propFunc);
+        submit(goat.goatShape, LAYER_GOAT);
+        for (int i = Config::FLAKE_TOTAL / 2; i < Config::FLAKE_TOTAL; i++) {
             // Places second half at a lower layer on the list so it appears above shapes
             if (snowFlakes[i].isActive) {
-                returnList.emplace_back(snowFlakes[i].snowFlakeShape);
+                submit(snowFlakes[i].snowFlakeShape, LAYER_UPPER_FLAKES);
             }
         }
-        returnList.emplace_back(ground);
+        submit(ground, LAYER_GROUND);
         if (enableOverlay) {
-            returnList.emplace_back(overlay);
+            submit(overlay, LAYER_OVERLAY);
         }
-        if (mainMenuObj.mainMenuTimer > 0) {
-            returnList.emplace_back(mainMenuObj.mainMenu);
-            returnList.emplace_back(mainMenuObj.splashText);
-            returnList.emplace_back(mainMenuObj.zID);
+        if (mainMenuObj.menuVisible) {
+            submit(mainMenuObj.mainMenu, LAYER_MENU);
+            submit(mainMenuObj.splashText, LAYER_SPLASH);
+            submit(mainMenuObj.zID, LAYER_ZID);
         }
+    }
+
+    /**
+     * Returns every shape that needs to be rendered, picking from the shapes that are active
+     */
+    std::list<shapeObject> getAllObjects() {
+        std::list<shapeObject> returnList;
+        forEachVisible([&](const shapeObject &shape, const glm::mat4 &, sceneLayer) { returnList.emplace_back(shape); });
         return returnList;
     }
 
+    /**
+     * Writes a draw record for every shape and group of props that needs to be rendered into
+     * the snapshot and sorts them. The snapshot keeps its memory between ticks so nothing is
+     * allocated once it has grown
+     */
+    void fillSnapshot(renderSnapshot &snapshot) {
+        snapshot.clear();
+        snapshot.scroll = (float)((scrolledTicks % SCROLL_WRAP_TICKS) * (double)Config::SCROLL_SPEED);
+        snapshot.menuFrame = mainMenuObj.shownFrame();
+        snapshot.showHud = hudVisible;
+        snapshot.activeFlakes = activeFlakes;
+        snapshot.chunkEpoch = chunks.epoch();
+        forEachVisible([&](const shapeObject &shape, const glm::mat4 &model, sceneLayer layer) {
+            blendMode blend = blendModeOf(sceneryTextures.alphaOf(shape.textureID));
+            snapshot.add(layer, {shape.vao, shape.textureID, 0, shape.vertexCount, shape.uvParallax, blend, model});
+        }, [&](GLuint vao, const chunkDraw &draw, const glm::mat4 &model) {
+            blendMode blend = blendModeOf(sceneryTextures.alphaOf(draw.texture));
+            snapshot.add(LAYER_PROPS, {vao, draw.texture, draw.firstVertex, draw.vertexCount, 0, blend, model});
+        });
+        snapshot.sort();
+    }
+
+    /**
+     * Asks for the scene to be fitted to a new window size. Called by the window thread
+     */
+    void requestResize(int width, int height) {
+        resizeWidth = width;
+        resizeHeight = height;
+        resizePending = true;
+    }
+
+    /**
+     * Takes the latest window size asked for by the window thread, if there is one.
+     * The simulation loop applies it with adjustPositions
+     * @return bool whether the window was resized since the last call
+     */
+    bool takeResize(int &width, int &height) {
+        if (!resizePending.exchange(false)) return false;
+        width = resizeWidth;
+        height = resizeHeight;
+        return true;
+    }
+
+    /**
+     * Takes whether the main menu was skipped on this tick because no key was pressed in
+     * time. The simulation loop then starts the game from the next tick
+     * @return bool whether TIMER_AUTO_SKIP ran out since the last call
+     */
+    bool takeAutoSkip() {
+        bool due = autoSkipDue;
+        autoSkipDue = false;
+        return due;
+    }
+
+    /**
+     * Saves or restores everything a tick can change through a stateStream
+     */
+    template <typename Stream>
+    void transferState(Stream &stream) {
+        mainMenuObj.transferState(stream);
+        stream.shape(background);
+        stream.shape(moon);
+        stream.shape(clouds);
+        stream.shape(ground);
+        stream.shape(parallaxObj);
+        stream.shape(parallaxLoopObj);
+        for (snowFlakeObject<Config> &flake : snowFlakes) {
+            flake.transferState(stream);
+        }
+        goat.transferState(stream);
+
+        stream.field(enableOverlay);
+        stream.field(scrolledTicks);
+        timers.transferState(stream);
+        stream.field(pallxSpawned);
+        stream.field(sinCurveX);
+        stream.field(activeFlakes);
+        if (stream.isLoading()) chunks.clear();
+        chunks.transferState(stream);
+
+        if (stream.isLoading()) {
+            // Loads the textures of the objects that were on screen, and makes the chunks
+            // around the loaded scroll position again
+            sceneryTextures.releaseAll();
+            if (pallxSpawned) sceneryTextures.use(parallaxObj.textureID);
+            chunks.scrollTo(scrolledTicks * (double)Config::SCROLL_SPEED);
+        }
+    }
+
+    /**
+     * Hashes everything a tick can change. Two runs with the same checksum after a tick
+     * have the same scene
+     */
+    uint32_t checksum() {
+        uint32_t hash = 2166136261u;
+        forEachVisible([&](const shapeObject &shape, const glm::mat4 &, sceneLayer) {
+            hash = hashBytes(hash, &shape.textureID, sizeof(shape.textureID));
+            hash = hashBytes(hash, &shape.trans, sizeof(shape.trans));
+            hash = hashBytes(hash, &shape.rot, sizeof(shape.rot));
+            hash = hashBytes(hash, &shape.scale, sizeof(shape.scale));
+        });
+        hash = hashBytes(hash, &scrolledTicks, sizeof(scrolledTicks));
+        hash = hashBytes(hash, &sinCurveX, sizeof(sinCurveX));
+        hash = chunks.hash(hash);
+        hash = hashBytes(hash, &rdmState, sizeof(rdmState));
+        return hash;
+    }
+
     /**
      * Animates everything by one frame
      * @param gameState whether the game has started scrolling or not
      */
     void tickAll(bool gameState) {
+        tickTimers();
         // Tick following objects only when gameState is true
         if (gameState) {
-            if (coolDownTimer > 0) {
-                // Decreases object spawning cool down timer
-                coolDownTimer--;
-            }
             goat.nextFrame();
             tickGround();
-            tickFgObjA();
-            tickFgObjB();
             tickParallax();
         }
-        // Tick only main menu if its timer has not expired yet
-        if (mainMenuObj.mainMenuTimer > 0) {
+        // Tick only main menu if it has not scrolled off yet. It scrolls for MAIN_MENU_TIMER ticks
+        if (mainMenuObj.menuVisible) {
+            if (gameState && !timers.isScheduled(TIMER_MENU)) {
+                timers.schedule(TIMER_MENU, Config::MAIN_MENU_TIMER);
+                timers.cancel(TIMER_AUTO_SKIP);
+            }
             mainMenuObj.tickMainMenu(gameState);
         }
         // Animates the background sky and the snowflakes
-        background.textureID = skyAnimationFrames[rand() % MAX_FRAMES_SKY];
+        background.textureID = skyAnimationFrames[rdmInt() % Config::MAX_FRAMES_SKY];
         tickSnowFlake(gameState);
     }
 
     /**
-     * Moves the ground to the left and loops it around if needed
+     * Moves the scene's timers on by a tick and carries out whatever has run out. Only
+     * timers that run out on this tick are looked at
      */
-    void tickGround() {
-        // Ticks the immediate ground
-        if (translatedGroundPos < 0) {
-            // printMessageTime();
-            // std::cout << "Reset ground\n";
-            translatedGroundPos = 1;
-            ground.resetTransforms();
-            ground.trans = glm::translate(ground.trans, glm::vec3(0.0, GROUND_POS_Y, 0.0));
-            ground.scale = glm::scale(ground.scale, glm::vec3(GROUND_SCALE, GROUND_SCALE, 0.0));
-        }
-        ground.trans = glm::translate(ground.trans, glm::vec3(-SCROLL_SPEED, 0.0, 0.0));
-        translatedGroundPos -= SCROLL_SPEED / 2;
-
-        // Ticks the tree loop in the background
-        if (translatedParallaxLoopPos < 0) {
-            // printMessageTime();
-            // std::cout << "Reset tree loop\n";
-            translatedParallaxLoopPos = 1;
-            parallaxLoopObj.resetTransforms();
-            parallaxLoopObj.trans = glm::translate(parallaxLoopObj.trans, glm::vec3(0.0, TREE_LOOP_POS_Y, 0.0));
-        }
-        parallaxLoopObj.trans = glm::translate(parallaxLoopObj.trans, glm::vec3(-SCROLL_SPEED / 10, 0.0, 0.0));
-        translatedParallaxLoopPos -= SCROLL_SPEED / 10;
-
-    }
-
-    /**
-     * Animates the next frame of foreground object A
-     */
-    void tickFgObjA() {
-        if (fgObjASpawned) {
-            foregroundObjA.trans = glm::translate(foregroundObjA.trans, glm::vec3(-SCROLL_SPEED, 0.0, 0.0));
-            fgObjATimer -= 1;
-            if (fgObjATimer < 0) {
-                printMessageTime();
-                std::cout << "ObjA has reached the end\n";
-                fgObjATimer = FG_TIMER;
-                foregroundObjA.resetTransforms();
-                foregroundObjA.scale = glm::scale(foregroundObjA.scale, glm::vec3(FG_SCALE, FG_SCALE, 0.0));
-                foregroundObjA.trans = glm::translate(foregroundObjA.trans, glm::vec3(2.5, FG_POS_Y, 0.0));
-                fgObjASpawned = false;
-            }
-        } else {
-            if (rand() % BG_SPAWN_CHANCE == 0 && coolDownTimer == 0) {
-                coolDownTimer = FG_COOLDOWN;
-                foregroundObjA.textureID = possibleTexID[rand() % TOTAL_FG_TEX];
-                printMessageTime();
-                std::cout << "ObjA spawned with texture ID: " << foregroundObjA.textureID << "\n";
-                fgObjASpawned = true;
+    void tickTimers() {
+        timers.advance([&](int timer) {
+            switch (timer) {
+                case TIMER_PARALLAX:
+                    printMessageTime();
+                    std::cout << "Parallax has reached the end\n";
+                    sceneryTextures.release(parallaxObj.textureID);
+                    parallaxObj.resetTransforms();
+                    parallaxObj.trans = glm::translate(parallaxObj.trans, glm::vec3(Config::PARALLAX_POS_X, Config::PARALLAX_POS_Y, 0.0));
+                    pallxSpawned = false;
+                    break;
+                case TIMER_MENU:
+                    mainMenuObj.menuVisible = false;
+                    break;
+                case TIMER_AUTO_SKIP:
+                    autoSkipDue = true;
+                    break;
+                default:
+                    // The flake respawns the next time the snowflakes are ticked
+                    snowFlakes[timer - TIMER_FIRST_FLAKE].flakeLifeTime = 0;
+                    break;
             }
-        }
+        });
     }
 
     /**
-     * Animates the next frame of foreground object B
+     * Scrolls the ground, tree loop and clouds to the left. Their geometry never moves,
+     * the vertex shader offsets their textures by the scroll distance instead. The props
+     * scroll with the ground, and new chunks of them are asked for as they come up
      */
-    void tickFgObjB() {
-        if (fgObjBSpawned) {
-            foregroundObjB.trans = glm::translate(foregroundObjB.trans, glm::vec3(-SCROLL_SPEED, 0.0, 0.0));
-            fgObjBTimer -= 1;
-            if (fgObjBTimer < 0) {
-                printMessageTime();
-                std::cout << "ObjB has reached the end\n";
-                fgObjBTimer = FG_TIMER;
-                foregroundObjB.resetTransforms();
-                foregroundObjB.scale = glm::scale(foregroundObjB.scale, glm::vec3(FG_SCALE, FG_SCALE, 0.0));
-                foregroundObjB.trans = glm::translate(foregroundObjB.trans, glm::vec3(2.5, FG_POS_Y, 0.0));
-                fgObjBSpawned = false;
-            }
-        } else {
-            if (rand() % BG_SPAWN_CHANCE == 3 && coolDownTimer == 0) {
-                coolDownTimer = FG_COOLDOWN;
-                foregroundObjB.textureID = possibleTexID[rand() % TOTAL_FG_TEX];
-                printMessageTime();
-                std::cout << "ObjB spawned with texture ID: " << foregroundObjB.textureID << "\n";
-                fgObjBSpawned = true;
-            }
-        }
+    void tickGround() {
+        // The textures wrap every SCROLL_WRAP_TICKS, when every layer has scrolled a whole
+        // number of repeats, so that does not jump
+        scrolledTicks++;
+        chunks.scrollTo(scrolledTicks * (double)Config::SCROLL_SPEED);
     }
 
     /**
@@ -284,19 +399,13 @@ public:
      */
     void tickParallax() {
         if (pallxSpawned) {
-            parallaxObj.trans = glm::translate(parallaxObj.trans, glm::vec3(-(SCROLL_SPEED / PARALLAX_TIMER), 0.0, 0.0));
-            parallaxTimer -= 1;
-            if (parallaxTimer < 0) {
-                printMessageTime();
-                std::cout << "Parallax has reached the end\n";
-                parallaxTimer = PARALLAX_TIMER * FG_TIMER;
-                parallaxObj.resetTransforms();
-                parallaxObj.trans = glm::translate(parallaxObj.trans, glm::vec3(PARALLAX_POS_X, PARALLAX_POS_Y, 0.0));
-                pallxSpawned = false;
-            }
+            parallaxObj.trans = glm::translate(parallaxObj.trans, glm::vec3(-(Config::SCROLL_SPEED / Config::PARALLAX_TIMER), 0.0, 0.0));
         } else {
-            if (rand() % BG_SPAWN_CHANCE == 0) {
-                parallaxObj.textureID = possibleParaTexID[rand() % TOTAL_P_TEX];
+            if (rdmInt() % Config::BG_SPAWN_CHANCE == 0) {
+                timers.schedule(TIMER_PARALLAX, Config::PARALLAX_TIMER * Config::FG_TIMER + 1);
+                parallaxObj.textureID = possibleParaTexID[rdmInt() % Config::TOTAL_P_TEX];
+                // Starts loading the texture while the object is still off screen
+                sceneryTextures.use(parallaxObj.textureID);
                 printMessageTime();
                 std::cout << "Parallax spawned with texture ID: " << parallaxObj.textureID << "\n";
                 pallxSpawned = true;
@@ -309,12 +418,12 @@ public:
      * snow flakes
      */
     double windInfluence(bool gameState) {
-        double xCoefficient = M_PI / W_COEFFICIENT;
+        double xCoefficient = M_PI / Config::W_COEFFICIENT;
         double period = (2 * M_PI) / xCoefficient;
         // Only use vertical shift if the animation has started
-        double vertShift = (gameState) ? W_VERT_SHIFT : 0;
+        double vertShift = (gameState) ? Config::W_VERT_SHIFT : 0;
         // The sin curve
-        double sinCurveResult = W_AMPLITUDE * glm::sin(xCoefficient * sinCurveX) + vertShift;
+        double sinCurveResult = Config::W_AMPLITUDE * glm::sin(xCoefficient * sinCurveX) + vertShift;
         if (sinCurveX > period) {
             // Loops the X axis once it passes the sin curve period
             sinCurveX -= period;
@@ -323,53 +432,89 @@ public:
         return sinCurveResult;
     }
 
+    /**
+     * Sends a snowflake back to the top of the screen at a random x co-ordinate
+     * @param gameState whether the game has started scrolling or not
+     */
+    void resetFlakeTransform(int flakeNo, bool gameState) {
+        shapeObject &flakeShape = snowFlakes[flakeNo].snowFlakeShape;
+        flakeShape.resetTransforms();
+
+        // Scale it back down and translate it to the top of the screen
+        flakeShape.scale = glm::scale(flakeShape.scale, glm::vec3(Config::FLAKE_SCALE, Config::FLAKE_SCALE, 0.0));
+        flakeShape.trans = glm::translate(flakeShape.trans, glm::vec3(0.0, Config::FLAKE_POS_Y, 0.0));
+
+        // Randomly decide the x co-ordinate of the shape
+        float random = rdmNumGen();
+        if (rdmInt() % 2 == 0) {
+            // Randomly flip the direction of the x co-ordinate
+            random *= -1;
+        }
+
+        // Widens the range of where the snowflake can spawn and offsets it to the right
+        random *= 2;
+        random += (gameState) ? 1 : 0;
+        flakeShape.trans = glm::translate(flakeShape.trans, glm::vec3(random, 0.0, 0.0));
+    }
+
+    /**
+     * Makes a snowflake active straight away at the top of the screen with a full life time,
+     * without waiting for the spawn chance
+     * @param gameState whether the game has started scrolling or not
+     */
+    void spawnFlake(int flakeNo, bool gameState) {
+        resetFlakeTransform(flakeNo, gameState);
+        snowFlakes[flakeNo].isActive = true;
+        snowFlakes[flakeNo].flakeLifeTime = Config::FLAKE_TIMER;
+        timers.schedule(TIMER_FIRST_FLAKE + flakeNo, Config::FLAKE_TIMER);
+    }
+
     /**
      * Animates the next frame of each individual snowflake
      * and controls whether to spawn one or not
      * @param gameState whether the game has started scrolling or not
      */
     void tickSnowFlake(bool gameState) {
-        if (rand() % FLAKE_CHANCE == 0) {
-            // A chance to make a random snow flake active
-            snowFlakes[rand() % FLAKE_TOTAL].isActive = true;
+        if (rdmInt() % Config::FLAKE_CHANCE == 0 && activeFlakes < flakeBudget) {
+            // A chance to make a random snow flake active, as long as the budget allows it.
+            // Its life time starts counting down from now
+            int flakeNo = rdmInt() % Config::FLAKE_TOTAL;
+            if (!snowFlakes[flakeNo].isActive) {
+                snowFlakes[flakeNo].isActive = true;
+                timers.schedule(TIMER_FIRST_FLAKE + flakeNo, snowFlakes[flakeNo].flakeLifeTime);
+            }
         } 
         sinCurveX += 0.1;
-        for (int i = 0; i < FLAKE_TOTAL; i++) {
+        activeFlakes = 0;
+        for (int i = 0; i < Config::FLAKE_TOTAL; i++) {
             // Loops through all snowflakes to animate them
             if (snowFlakes[i].isActive) {
                 if (snowFlakes[i].flakeLifeTime == 0) {
                     // Reset its lifetimer and its transformations
                     snowFlakes[i].isActive = false;
-                    snowFlakes[i].flakeLifeTime = FLAKE_TIMER;
-                    snowFlakes[i].snowFlakeShape.resetTransforms();
-
-                    // Scale it back down and translate it to the top of the screen
-                    snowFlakes[i].snowFlakeShape.scale = glm::scale(snowFlakes[i].snowFlakeShape.scale, glm::vec3(FLAKE_SCALE, FLAKE_SCALE, 0.0));
-                    snowFlakes[i].snowFlakeShape.trans = glm::translate(snowFlakes[i].snowFlakeShape.trans, glm::vec3(0.0, FLAKE_POS_Y, 0.0));
-                    
-                    // Randomly decide the x co-ordinate of the shape
-                    float random = rdmNumGen();
-                    if (rand() % 2 == 0) {
-                        // Randomly flip the direction of the x co-ordinate
-                        random *= -1;
-                    }
-
-                    // Widens the range of where the snowflake can spawn and offsets it to the right
-                    random *= 2;
-                    random += (gameState) ? 1 : 0;
-                    snowFlakes[i].snowFlakeShape.trans = glm::translate(snowFlakes[i].snowFlakeShape.trans, glm::vec3(random, 0.0, 0.0));
+                    snowFlakes[i].flakeLifeTime = Config::FLAKE_TIMER;
+                    timers.cancel(TIMER_FIRST_FLAKE + i);
+                    resetFlakeTransform(i, gameState);
 
                 } else {
-                    // Decreases snowflakes life time and moves it down left direction
+                    // Moves the snowflake down in the left direction
                     float fallSpeed = -0.01 * snowFlakes[i].velMultiplier;
-                    float xSpeed = (gameState) ?  -SCROLL_SPEED + snowFlakes[i].velX : 0;
-                    snowFlakes[i].flakeLifeTime--;
+                    float xSpeed = (gameState) ?  -Config::SCROLL_SPEED + snowFlakes[i].velX : 0;
                     snowFlakes[i].snowFlakeShape.trans = glm::translate(snowFlakes[i].snowFlakeShape.trans, glm::vec3(xSpeed + windInfluence(gameState), fallSpeed, 0.0));
                     if (snowFlakes[i].rotDirection) {
                         snowFlakes[i].snowFlakeShape.rot = glm::rotate(snowFlakes[i].snowFlakeShape.rot, glm::radians(snowFlakes[i].rotSpeed), glm::vec3(0.0, 0.0, 1.0));
                     } else {
                         snowFlakes[i].snowFlakeShape.rot = glm::rotate(snowFlakes[i].snowFlakeShape.rot, glm::radians(-snowFlakes[i].rotSpeed), glm::vec3(0.0, 0.0, 1.0));
                     }
+
+                    // Returns the flake to the pool early once it has fallen below the screen, or
+                    // scrolled off the left while the scene is moving, as it will not come back
+                    const glm::vec4 &flakePos = snowFlakes[i].snowFlakeShape.trans[3];
+                    const float margin = 2 * Config::FLAKE_SCALE;
+                    if (flakePos.y < -1 - margin || (gameState && flakePos.x < -1 - margin)) {
+                        snowFlakes[i].flakeLifeTime = 0;
+                    }
+                    activeFlakes++;
                 }   
             }
             
@@ -384,8 +529,8 @@ public:
         moon.resetTransforms();
         clouds.resetTransforms();
         mainMenuObj.mainMenu.resetTransforms();
-        moon.scale = glm::scale(moon.scale, glm::vec3(MOON_SCALE, MOON_SCALE, 0.0));
-        moon.trans = glm::translate(moon.trans, glm::vec3(MOON_POS_XY, MOON_POS_XY, 0.0));
+        moon.scale = glm::scale(moon.scale, glm::vec3(Config::MOON_SCALE, Config::MOON_SCALE, 0.0));
+        moon.trans = glm::translate(moon.trans, glm::vec3(Config::MOON_POS_XY, Config::MOON_POS_XY, 0.0));
 
         // Readjusting cloud and moon based on the new width/height
         if (width > height) {
@@ -396,27 +541,31 @@ public:
     }
 
     /**
-     * Updates all the shapes based on the key inputs.
-     * Also controls what changes about the scene depending on what key is pressed
+     * Updates all the shapes based on the key inputs queued since the last tick.
+     * Also controls what changes about the scene depending on what action is performed.
+     * Anything that touches the window is left for handleWindowRequests
      */
-    void checkKeyInputs(GLFWwindow *win) {
-        // Loops through the entire array to check if the key is pressed or not
-        for (int keyNo = 0; keyNo < TOTAL_KEYS; keyNo++) {
-            // If key i is not pressed, skip to the next loop. If D is not pressed, reset the animation length
-            if (!isKeyPressed[keyNo] && keyNo == GLFW_KEY_D) goat.changeAnimationLength(ANIM_FRAME_LEN);
-            if (!isKeyPressed[keyNo]) continue;
-
-            switch (keyNo) {
-                case GLFW_KEY_ESCAPE:
-                    glfwSetWindowShouldClose(win, GLFW_TRUE);
+    void checkKeyInputs() {
+        input.beginTick();
+
+        // Only the bound actions are checked, in the order they are listed
+        for (int actionNo = 0; actionNo < ACTION_TOTAL; actionNo++) {
+            inputAction action = (inputAction)actionNo;
+            // If D is not held, reset the animation length
+            if (!input.isActive(action) && action == ACTION_WALK_RIGHT) goat.changeAnimationLength(Config::ANIM_FRAME_LEN);
+            if (!input.isActive(action)) continue;
+
+            switch (action) {
+                case ACTION_QUIT:
+                    quitRequested = true;
                     break;
-                case GLFW_KEY_SPACE:
+                case ACTION_JUMP:
                     goat.jump();
                     // Allows for multiple key presses
                     break;
-                case GLFW_KEY_A:
+                case ACTION_WALK_LEFT:
                     goat.walkLeft();
-                    if (!isKeyPressed[GLFW_KEY_D] && !isKeyPressed[GLFW_KEY_SPACE] && goat.getWalkedDistance() > -GOAT_WALK_RANGE) {
+                    if (!input.isActive(ACTION_WALK_RIGHT) && !input.isActive(ACTION_JUMP) && goat.getWalkedDistance() > -Config::GOAT_WALK_RANGE) {
                         // Sets texture to idle position if the space key or D is not pressed
                         goat.goatShape.textureID = goat.goatAnimationFrames[0];
                         goat.changeAnimationFrame(1);
@@ -426,36 +575,64 @@ public:
                         goat.walkLeft();
                     }
                     break;
-                case GLFW_KEY_D:
+                case ACTION_WALK_RIGHT:
                     goat.walkRight();
                     // Quickens the animation frame length if the goat has not walked out of range
-                    if (goat.getWalkedDistance() < GOAT_WALK_RANGE && !isKeyPressed[GLFW_KEY_A]) {
-                        goat.changeAnimationLength(ANIM_FRAME_LEN / 4);
+                    if (goat.getWalkedDistance() < Config::GOAT_WALK_RANGE && !input.isActive(ACTION_WALK_LEFT)) {
+                        goat.changeAnimationLength(Config::ANIM_FRAME_LEN / 4);
                     } else {
-                        goat.changeAnimationLength(ANIM_FRAME_LEN);
+                        goat.changeAnimationLength(Config::ANIM_FRAME_LEN);
                     }
                     break;
-                case GLFW_KEY_TAB:
-                    // Toggle overlay on or off
+                case ACTION_TOGGLE_OVERLAY:
+                    // Toggle overlay on or off once per press
+                    if (!input.wasPressed(action)) break;
                     printMessageTime();
                     std::cout << "Overlay set to " << !enableOverlay << "\n";
                     enableOverlay = !enableOverlay;
-                    isKeyPressed[keyNo] = false;
                     break;
-                case GLFW_KEY_F:
+                case ACTION_TOGGLE_HUD:
+                    // Toggle the frame rate and flake count on or off once per press
+                    if (input.wasPressed(action)) hudVisible = !hudVisible;
+                    break;
+                case ACTION_MEMORY_REPORT:
+                    // Prints how much memory each part of the program is using
+                    if (input.wasPressed(action)) memoryReportRequested = true;
+                    break;
+                case ACTION_FULLSCREEN:
                     // Makes the screen fullscreen unless screen saver mode is enabled
-                    if (SCREENSAVER_MODE) break;
-                    if (glfwGetWindowAttrib(win, GLFW_MAXIMIZED)) {
-                        glfwRestoreWindow(win);
-                        glfwSetWindowSize(win, SCREEN_WIDTH, SCREEN_HEIGHT);
-                        glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-                    } else {
-                        glfwMaximizeWindow(win);
-                    }
-                    isKeyPressed[keyNo] = false;
+                    if (!Config::SCREENSAVER_MODE && input.wasPressed(action)) fullscreenRequested = true;
+                    break;
+                default:
                     break;
             }
 
         }
+
+        input.endTick();
+    }
+
+    /**
+     * Carries out the window actions asked for by key presses. Must be called by the
+     * thread that owns the window
+     */
+    void handleWindowRequests(GLFWwindow *win) {
+        if (quitRequested.exchange(false)) {
+            glfwSetWindowShouldClose(win, GLFW_TRUE);
+        }
+        if (memoryReportRequested.exchange(false)) {
+            printMessageTime();
+            std::cout << "Memory report (KiB):\n";
+            memTracker.printReport();
+        }
+        if (fullscreenRequested.exchange(false)) {
+            if (glfwGetWindowAttrib(win, GLFW_MAXIMIZED)) {
+                glfwRestoreWindow(win);
+                glfwSetWindowSize(win, Config::SCREEN_WIDTH, Config::SCREEN_HEIGHT);
+                glViewport(0, 0, Config::SCREEN_WIDTH, Config::SCREEN_HEIGHT);
+            } else {
+                glfwMaximizeWindow(win);
+            }
+        }
     }
-};
\ No newline at end of file
+};
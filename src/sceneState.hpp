@@ -0,0 +1,130 @@
+/**
+ * File contains stateStream, which saves or restores the whole simulation state in a
+ * versioned binary format, and the functions that save/load a scene with it. Used to
+ * start up from a pre-warmed scene and to give benchmarks a fixed starting point
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+// .state file layout: magic, version, FLAKE_TOTAL, texture count, then every field in the
+// order the transferState functions visit them
+const char STATE_MAGIC[4] = {'S', 'T', 'A', 'T'};
+const uint32_t STATE_VERSION = 6;
+
+/**
+ * Writes fields out or reads them back in. Every struct with state has one transferState
+ * function that is used for both, so saving and loading can never visit fields in a
+ * different order
+ */
+struct stateStream {
+private:
+    std::ostream *out = nullptr;
+    std::istream *in = nullptr;
+
+public:
+    // False when the textures were made in a different order to the saved ones, in which
+    // case shapes keep the textures they already have
+    bool restoreTextures = true;
+
+    stateStream(std::ostream &output) : out(&output) {}
+    stateStream(std::istream &input) : in(&input) {}
+
+    bool isLoading() {
+        return in != nullptr;
+    }
+
+    /**
+     * Whether everything so far was written/read successfully
+     */
+    bool ok() {
+        return out ? (bool)*out : (bool)*in;
+    }
+
+    /**
+     * Saves or restores a plain value
+     */
+    template <typename T>
+    void field(T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be stored directly");
+        if (out) {
+            out->write((const char *)&value, sizeof(T));
+        } else {
+            in->read((char *)&value, sizeof(T));
+        }
+    }
+
+    /**
+     * Saves or restores a texture. Stored as its position in listOfEveryTexID, as
+     * texture names are not the same from one run to the next
+     */
+    void texture(GLuint &tex) {
+        int32_t index = out ? textureIndex(tex) : -1;
+        field(index);
+        if (in && restoreTextures && index >= 0) {
+            tex = textureAtIndex(index);
+        }
+    }
+
+    /**
+     * Saves or restores a shape's texture and transformations. Its buffers stay as they are
+     */
+    void shape(shapeObject &shape) {
+        texture(shape.textureID);
+        field(shape.trans);
+        field(shape.rot);
+        field(shape.scale);
+    }
+};
+
+/**
+ * Writes the whole simulation state of a scene
+ * @param gameState whether the menu has started scrolling
+ * @return bool whether everything was written
+ */
+template <typename Config>
+bool saveSceneState(std::ostream &output, scene<Config> &sceneObjects, bool gameState) {
+    stateStream stream(output);
+    uint32_t header[3] = {STATE_VERSION, (uint32_t)Config::FLAKE_TOTAL, (uint32_t)listOfEveryTexID.size()};
+    output.write(STATE_MAGIC, sizeof(STATE_MAGIC));
+    stream.field(header);
+    stream.field(gameState);
+    stream.field(rdmState);
+    sceneObjects.transferState(stream);
+    return stream.ok();
+}
+
+/**
+ * Restores the whole simulation state of a scene. The scene must already have its
+ * shapes and textures made
+ * @return bool whether the state was valid and matched this build's settings
+ */
+template <typename Config>
+bool loadSceneState(std::istream &input, scene<Config> &sceneObjects, bool &gameState) {
+    stateStream stream(input);
+    char magic[4];
+    uint32_t header[3];
+    input.read(magic, sizeof(magic));
+    stream.field(header);
+    if (!stream.ok() || memcmp(magic, STATE_MAGIC, sizeof(magic)) != 0 || header[0] != STATE_VERSION) return false;
+    // The flake pool is a fixed size, so a state from a different profile cannot be used
+    if (header[1] != (uint32_t)Config::FLAKE_TOTAL) return false;
+    stream.restoreTextures = header[2] == (uint32_t)listOfEveryTexID.size();
+
+    stream.field(gameState);
+    stream.field(rdmState);
+    sceneObjects.transferState(stream);
+    return stream.ok();
+}
@@ -0,0 +1,393 @@
+/**
+ * File contains sceneryChunks, which streams the foreground scenery in as the scene scrolls.
+ * The world is split into chunks CHUNK_WIDTH wide, and the props in a chunk are placed only
+ * from the world's seed and the chunk's number, so a chunk looks the same every time it is
+ * made. Chunks are laid out on a separate thread a few chunks ahead of the screen into a
+ * pool of vertex buffers, which are reused once their chunk has scrolled off and the render
+ * loop has moved past every snapshot that drew it. The work done each tick stays the same
+ * however far the scene has scrolled
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Where a slot of the pool is between being given a chunk and being drawn
+ */
+enum chunkState {
+    CHUNK_FREE,        // Not holding a chunk
+    CHUNK_GENERATING,  // Waiting for or being laid out by the generating thread
+    CHUNK_GENERATED,   // Laid out, waiting for the render loop to upload it
+    CHUNK_RESIDENT,    // On the GPU and drawn while it is on screen
+    CHUNK_RETIRED      // Scrolled off, but still in snapshots the render loop may draw again
+};
+
+/**
+ * The props in a chunk that share a texture, drawn with one call
+ */
+struct chunkDraw {
+    GLuint texture;
+    GLint firstVertex;
+    GLsizei vertexCount;
+};
+
+/**
+ * A slot of the pool. Its vertex array and buffer are made once and refilled with each
+ * chunk it is given
+ */
+template <typename Config>
+struct chunkSlot {
+    std::atomic<chunkState> state{CHUNK_FREE};
+    long long chunk = -1;
+    // Epoch the chunk scrolled off in. The slot is freed once a later epoch has been presented
+    long retiredEpoch = 0;
+    GLuint vao = 0, vbo = 0;
+    // Vertices from the generating thread, kept so their memory is reused by the next chunk
+    std::vector<packedVert> packed;
+    std::array<chunkDraw, Config::CHUNK_PROPS> draws;
+    int drawCount = 0;
+};
+
+/**
+ * Keeps the chunks on and just ahead of the screen laid out and on the GPU. The
+ * simulation scrolls them and says which to make, the render loop uploads them
+ */
+template <typename Config>
+struct sceneryChunks {
+    static_assert(Config::CHUNK_POOL > Config::CHUNK_AHEAD, "CHUNK_POOL must be larger than CHUNK_AHEAD");
+
+    // Furthest a prop reaches past the edges of its chunk, half the widest prop
+    static constexpr float PROP_REACH = 0.7f * Config::FG_SCALE;
+
+private:
+    std::array<chunkSlot<Config>, Config::CHUNK_POOL> slots;
+    // Textures props can have, and the manager that loads them
+    const GLuint *propTextures = nullptr;
+    int propTextureCount = 0;
+    textureResidency<Config> *textures = nullptr;
+
+    // Saved with the scene
+    uint32_t worldSeed = 0;
+    // Worked out from the scene's scroll. The left edge of the screen is chunkScroll past the
+    // start of firstChunk
+    long long firstChunk = 0;
+    float chunkScroll = 0;
+    // Moves on each time chunks are retired, so snapshots filled after that can be told apart
+    // from the ones that may still draw them. Only the simulation changes it
+    long retireEpoch = 1;
+    // Epoch of the newest snapshot the render loop has started drawing
+    std::atomic<long> presentedEpoch{0};
+
+    std::mutex queueLock;
+    std::condition_variable generateWanted, generateFinished;
+    std::deque<int> generateQueue;
+    std::thread generator;
+    bool stopping = false;
+
+public:
+    sceneryChunks() {
+        generator = std::thread([this] { generateLoop(); });
+    }
+
+    ~sceneryChunks() {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            stopping = true;
+        }
+        generateWanted.notify_all();
+        generator.join();
+    }
+
+    /**
+     * Makes the pool's buffers and asks for the chunks on the screen. Must be called
+     * before the simulation starts
+     * @param texIDs textures props can have, which must outlive the chunks
+     * @param seed what every chunk is placed from
+     */
+    void setup(textureResidency<Config> &residency, const GLuint *texIDs, int texCount, uint32_t seed) {
+        textures = &residency;
+        propTextures = texIDs;
+        propTextureCount = texCount;
+        worldSeed = seed;
+
+        // Every slot can hold a chunk with the most props
+        const size_t capacity = (size_t)Config::CHUNK_PROPS * 6;
+        for (chunkSlot<Config> &slot : slots) {
+            slot.packed.reserve(capacity);
+            glGenVertexArrays(1, &slot.vao);
+            glGenBuffers(1, &slot.vbo);
+            glBindVertexArray(slot.vao);
+            glBindBuffer(GL_ARRAY_BUFFER, slot.vbo);
+            glBufferData(GL_ARRAY_BUFFER, (GLintptr)(sizeof(packedVert) * capacity), nullptr, GL_STATIC_DRAW);
+            memTracker.trackBuffer(slot.vbo, MEM_SHAPE_BUFFERS, sizeof(packedVert) * capacity, sizeof(packedVert) * capacity);
+
+            // Same layout as the meshes in meshRegistry
+            glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, sizeof(packedVert), (void *)offsetof(packedVert, x));
+            glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(packedVert), (void *)offsetof(packedVert, u));
+            glEnableVertexAttribArray(0);
+            glEnableVertexAttribArray(1);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        scrollTo(0);
+    }
+
+    /**
+     * Moves the chunks to where the scene has scrolled to, recycling the ones that have
+     * gone off screen and asking for the ones coming up
+     * @param scrolled how far the scene has scrolled since it started, without wrapping
+     */
+    void scrollTo(double scrolled) {
+        // The first chunk is kept until its props are past the left edge of the screen
+        firstChunk = (long long)std::floor((scrolled - PROP_REACH) / Config::CHUNK_WIDTH);
+        chunkScroll = (float)(scrolled - firstChunk * (double)Config::CHUNK_WIDTH);
+        streamAhead();
+    }
+
+    /**
+     * Calls func with the vertex array, draw and transformation of every group of props on
+     * the screen. Chunks that are not on the GPU yet are skipped
+     */
+    template <typename Func>
+    void forEachVisible(Func func) {
+        for (chunkSlot<Config> &slot : slots) {
+            if (slot.state.load(std::memory_order_acquire) != CHUNK_RESIDENT) continue;
+            // Chunks start at the left edge of the screen
+            float left = (slot.chunk - firstChunk) * Config::CHUNK_WIDTH - chunkScroll - 1;
+            if (left - PROP_REACH > 1 || left + Config::CHUNK_WIDTH + PROP_REACH < -1) continue;
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(left, 0.0, 0.0));
+            for (int i = 0; i < slot.drawCount; i++) {
+                func(slot.vao, slot.draws[i], model);
+            }
+        }
+    }
+
+    /**
+     * The epoch snapshots filled now are stamped with. See update
+     */
+    long epoch() const {
+        return retireEpoch;
+    }
+
+    /**
+     * Uploads the chunks that have been laid out. Called by the render loop before drawing.
+     * Older snapshots are never drawn once a newer one has been, so chunks retired before
+     * presented can have their slots reused
+     * @param presented the epoch of the snapshot about to be drawn
+     */
+    void update(long presented) {
+        presentedEpoch.store(presented, std::memory_order_release);
+        for (chunkSlot<Config> &slot : slots) {
+            if (slot.state.load(std::memory_order_acquire) != CHUNK_GENERATED) continue;
+            glBindBuffer(GL_ARRAY_BUFFER, slot.vbo);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, (GLintptr)(sizeof(packedVert) * slot.packed.size()), slot.packed.data());
+            slot.state.store(CHUNK_RESIDENT, std::memory_order_release);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    /**
+     * Waits for every chunk that has been asked for to be laid out. Used before the first
+     * frame and before loading a scene
+     */
+    void finishGenerating() {
+        std::unique_lock<std::mutex> guard(queueLock);
+        generateFinished.wait(guard, [&] {
+            for (chunkSlot<Config> &slot : slots) {
+                if (slot.state == CHUNK_GENERATING) return false;
+            }
+            return true;
+        });
+    }
+
+    /**
+     * Frees every slot without releasing their textures. Used when loading a scene, which
+     * releases every texture itself and then calls streamAhead. Must not be called while the
+     * render loop can draw the chunks
+     */
+    void clear() {
+        finishGenerating();
+        for (chunkSlot<Config> &slot : slots) {
+            slot.state = CHUNK_FREE;
+            slot.chunk = -1;
+        }
+    }
+
+    /**
+     * Retires the chunks that have scrolled off and gives the chunks from the first one to
+     * CHUNK_AHEAD after it to free slots. Chunks that are still being laid out or uploaded
+     * are left until they are on the GPU. A retired slot is only freed once the render loop
+     * has presented a snapshot filled after it was retired, as older ones still draw from it
+     */
+    void streamAhead() {
+        long presented = presentedEpoch.load(std::memory_order_acquire);
+        bool retired = false;
+        for (chunkSlot<Config> &slot : slots) {
+            chunkState state = slot.state.load(std::memory_order_acquire);
+            if (state == CHUNK_RESIDENT && slot.chunk < firstChunk) {
+                for (int i = 0; i < slot.drawCount; i++) {
+                    for (int prop = 0; prop < slot.draws[i].vertexCount / 6; prop++) textures->release(slot.draws[i].texture);
+                }
+                slot.retiredEpoch = retireEpoch;
+                slot.state = CHUNK_RETIRED;
+                retired = true;
+            } else if (state == CHUNK_RETIRED && presented > slot.retiredEpoch) {
+                slot.state = CHUNK_FREE;
+            }
+        }
+        if (retired) retireEpoch++;
+
+        for (long long chunk = firstChunk; chunk < firstChunk + Config::CHUNK_AHEAD; chunk++) {
+            bool inPool = false;
+            int freeSlot = -1;
+            for (int i = 0; i < Config::CHUNK_POOL; i++) {
+                chunkState state = slots[i].state.load(std::memory_order_acquire);
+                if (state != CHUNK_FREE && slots[i].chunk == chunk) inPool = true;
+                if (state == CHUNK_FREE && freeSlot == -1) freeSlot = i;
+            }
+            if (inPool) continue;
+            // Tried again next tick, once a chunk behind the screen has been uploaded and retired,
+            // and the render loop has moved past it
+            if (freeSlot == -1) break;
+
+            std::lock_guard<std::mutex> guard(queueLock);
+            slots[freeSlot].chunk = chunk;
+            slots[freeSlot].state = CHUNK_GENERATING;
+            generateQueue.push_back(freeSlot);
+            generateWanted.notify_one();
+        }
+    }
+
+    /**
+     * Saves or restores the seed through a stateStream. The chunks themselves are made
+     * again from it and the scene's scroll
+     */
+    template <typename Stream>
+    void transferState(Stream &stream) {
+        stream.field(worldSeed);
+    }
+
+    /**
+     * Adds the seed to a hash
+     */
+    uint32_t hash(uint32_t hash) {
+        return hashBytes(hash, &worldSeed, sizeof(worldSeed));
+    }
+
+    /**
+     * Deletes the pool's buffers
+     */
+    void deleteBuffers() {
+        finishGenerating();
+        for (chunkSlot<Config> &slot : slots) {
+            memTracker.untrackBuffer(slot.vbo);
+            glDeleteBuffers(1, &slot.vbo);
+            glDeleteVertexArrays(1, &slot.vao);
+            slot.vbo = slot.vao = 0;
+            slot.state = CHUNK_FREE;
+        }
+    }
+
+private:
+    /**
+     * Lays out chunks as they are asked for until the pool is destroyed
+     */
+    void generateLoop() {
+        std::unique_lock<std::mutex> guard(queueLock);
+        while (true) {
+            generateWanted.wait(guard, [&] { return stopping || !generateQueue.empty(); });
+            if (stopping) return;
+            chunkSlot<Config> &slot = slots[generateQueue.front()];
+            generateQueue.pop_front();
+
+            // Only this thread touches a slot that is generating
+            guard.unlock();
+            generate(slot);
+            guard.lock();
+
+            slot.state.store(CHUNK_GENERATED, std::memory_order_release);
+            generateFinished.notify_all();
+        }
+    }
+
+    /**
+     * Places the props of the slot's chunk. Uses its own random numbers rather than
+     * rdmInt, so the simulation's stream is the same however far ahead chunks are made
+     */
+    void generate(chunkSlot<Config> &slot) {
+        uint64_t state = ((uint64_t)worldSeed << 32) ^ (uint64_t)slot.chunk;
+        // splitmix64, which gives unrelated numbers for neighbouring chunks
+        auto next = [&state]() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        auto nextFloat = [&]() { return (float)(next() >> 40) / (float)(1 << 24); };
+
+        struct prop {
+            int texture;
+            float x, scale;
+            bool flipped;
+        };
+        std::array<prop, Config::CHUNK_PROPS> props;
+        int propCount = Config::CHUNK_MIN_PROPS + next() % (Config::CHUNK_PROPS - Config::CHUNK_MIN_PROPS + 1);
+        for (int i = 0; i < propCount; i++) {
+            // Each prop gets an even share of the chunk so they do not all bunch up
+            float share = Config::CHUNK_WIDTH / propCount;
+            props[i].x = (i + nextFloat()) * share;
+            props[i].texture = next() % propTextureCount;
+            props[i].scale = Config::FG_SCALE * (Config::CHUNK_MIN_SCALE + (1 - Config::CHUNK_MIN_SCALE) * nextFloat());
+            props[i].flipped = next() % 2;
+        }
+        // Props sharing a texture are drawn together. Their order within the chunk does not matter
+        std::sort(props.begin(), props.begin() + propCount, [](const prop &a, const prop &b) { return a.texture < b.texture; });
+
+        slot.packed.clear();
+        slot.drawCount = 0;
+        for (int i = 0; i < propCount; i++) {
+            const prop &p = props[i];
+            GLuint tex = propTextures[p.texture];
+            if (slot.drawCount == 0 || slot.draws[slot.drawCount - 1].texture != tex) {
+                slot.draws[slot.drawCount++] = {tex, (GLint)slot.packed.size(), 0};
+            }
+            // Starts loading the texture while the chunk is still off screen
+            textures->use(tex);
+
+            // The same quad as the old foreground objects, standing on the same spot
+            float bottom = Config::FG_POS_Y - Config::FG_SCALE;
+            float left = p.x - 0.7f * p.scale, right = p.x + 0.7f * p.scale, top = bottom + 2 * p.scale;
+            float uLeft = p.flipped ? 1 : 0, uRight = 1 - uLeft;
+            const vert corners[6] = {
+                // 1st Triangle
+                {{ right,    top, 0, 1}, { uRight, 1}},
+                {{ right, bottom, 0, 1}, { uRight, 0}},
+                {{  left, bottom, 0, 1}, {  uLeft, 0}},
+                // 2nd Triangle
+                {{ right,    top, 0, 1}, { uRight, 1}},
+                {{  left, bottom, 0, 1}, {  uLeft, 0}},
+                {{  left,    top, 0, 1}, {  uLeft, 1}},
+            };
+            for (const vert &v : corners) {
+                slot.packed.push_back(meshRegistry::pack(v));
+            }
+            slot.draws[slot.drawCount - 1].vertexCount += 6;
+        }
+    }
+};
@@ -11,41 +11,22 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
-// Required external variables
-extern const float GOAT_SCALE;
-extern const float GOAT_POS_Y;
-
 /**
- * Creates a shape struct with the given vertices and returns it
+ * Creates a shape struct with the given vertices and returns it. Shapes with the same
+ * vertices share one mesh
  * @param std::vector<vert> a group of vertices
+ * @param memSubsystem what the shape's buffer is counted against
  * @return shapeObject
  */
-shapeObject createShape(std::vector<vert> vert_t) {
-
-    shapeObject returnShape;
-    returnShape.vertices = vert_t;
-
-    glGenVertexArrays(1, &returnShape.vao);
+shapeObject createShape(const std::vector<vert> &vert_t, memSubsystem subsystem = MEM_SHAPE_BUFFERS) {
 
-    glGenBuffers(1, &returnShape.vbo);
+    const meshEntry &mesh = meshes.acquire(vert_t, subsystem);
 
-    // Binding and enabling Vertex Array Objects and Buffer Objects
-    glBindVertexArray(returnShape.vao);
-    glBindBuffer(GL_ARRAY_BUFFER, returnShape.vbo);
-
-    glBufferData(
-        GL_ARRAY_BUFFER,
-        (GLintptr)(sizeof(vert) * returnShape.vertices.size()),
-        returnShape.vertices.data(),
-        GL_STATIC_DRAW
-    );
-
-    // Pointing to first 4 = vertex co-ordinates; next 2 = texture co=ordinates
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(vert), (void *)(0 + offsetof(vert, vertexCoords)));
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(vert), (void *)(0 + offsetof(vert, textureCoords)));
- 
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
+    shapeObject returnShape;
+    returnShape.vao = mesh.vao;
+    returnShape.vertexCount = mesh.vertexCount;
+    returnShape.boundsMin = mesh.boundsMin;
+    returnShape.boundsMax = mesh.boundsMax;
 
     return returnShape;
 }
@@ -69,11 +50,29 @@ shapeObject createFlatSquare() {
     return createShape(vert);
 }
 
+/**
+ * Creates a shape with text laid out on it, centred in the same square createFlatSquare
+ * covers. The font shrinks for text that would not otherwise fit in the width
+ * @param maxWidth widest the text can be
+ * @param maxPixelSize largest a pixel of the font can be
+ * @return shapeObject
+ */
+shapeObject createText(const char *text, textStyle style, float maxWidth, float maxPixelSize) {
+    float pixelSize = std::min(maxPixelSize, maxWidth / textWidth(text));
+    std::vector<vert> vert;
+    layoutText(text, style, glm::vec2(0, textHeight(text) * pixelSize / 2), pixelSize, true, vert);
+
+    shapeObject returnShape = createShape(vert, MEM_MENU_FRAMES);
+    returnShape.textureID = fontAtlas;
+    return returnShape;
+}
+
 /**
  * Creates the goat object and translates and scales it appropriately
  * @return goatObject
  */
-goatObject createGoat() {
+template <typename Config>
+goatObject<Config> createGoat() {
     std::vector<vert> vert = {
         // 1st Triangle
         {{  1,  1,  0,  1}, {  1,  1}},
@@ -86,9 +85,9 @@ goatObject createGoat() {
     };
 
     shapeObject returnShape = createShape(vert);
-    returnShape.scale = glm::scale(returnShape.scale, glm::vec3(GOAT_SCALE, GOAT_SCALE, 0.0));
-    returnShape.trans = glm::translate(returnShape.trans, glm::vec3(0, GOAT_POS_Y, 0.0));
-    goatObject returnGoat;
+    returnShape.scale = glm::scale(returnShape.scale, glm::vec3(Config::GOAT_SCALE, Config::GOAT_SCALE, 0.0));
+    returnShape.trans = glm::translate(returnShape.trans, glm::vec3(0, Config::GOAT_POS_Y, 0.0));
+    goatObject<Config> returnGoat;
     returnGoat.goatShape = returnShape;
     return returnGoat;
 }
@@ -97,6 +96,7 @@ goatObject createGoat() {
  * Creates a large shape with a looping texture
  * @return shapeObject
  */
+template <typename Config>
 shapeObject createParallaxLoop() {
     std::vector<vert> vert = {
         // 1st Triangle
@@ -109,7 +109,8 @@ shapeObject createParallaxLoop() {
         {{ -2,  1,  0,  1}, {  0,  1}},
     };
     shapeObject returnObj = createShape(vert);
-    returnObj.trans = glm::translate(returnObj.trans, glm::vec3(0.0, TREE_LOOP_POS_Y, 0.0));
+    returnObj.trans = glm::translate(returnObj.trans, glm::vec3(0.0, Config::TREE_LOOP_POS_Y, 0.0));
+    returnObj.uvParallax = Config::TREE_LOOP_PARALLAX;
     return returnObj;
 }
 
@@ -117,7 +118,8 @@ shapeObject createParallaxLoop() {
  * Creates a shape and stores it in a snowFlakeObject
  * @return snowFlakeObject
  */
-snowFlakeObject createSnowFlake() {
+template <typename Config>
+snowFlakeObject<Config> createSnowFlake() {
     std::vector<vert> vert = {
         // 1st Triangle
         {{  1,  1,  0,  1}, {  1,  1}},
@@ -129,42 +131,20 @@ snowFlakeObject createSnowFlake() {
         {{ -1,  1,  0,  1}, {  0,  1}},
     };
 
-    shapeObject returnShape = createShape(vert);
-    snowFlakeObject returnFlakeObject;
+    shapeObject returnShape = createShape(vert, MEM_SNOWFLAKE_SHAPES);
+    snowFlakeObject<Config> returnFlakeObject;
     returnFlakeObject.snowFlakeShape = returnShape;
 
     return returnFlakeObject;
 }
 
-/**
- * Creates a background element and scales and translates it offscreen
- * @return shapeObject
- */
-shapeObject createBackgroundElement() {
-    std::vector<vert> vert = {
-        // 1st Triangle
-        {{  0.7,   1,  0,  1}, {  1,  1}},
-        {{  0.7,  -1,  0,  1}, {  1,  0}},
-        {{ -0.7,  -1,  0,  1}, {  0,  0}},
-        // 2nd Triangle
-        {{  0.7,   1,  0,  1}, {  1,  1}},
-        {{ -0.7,  -1,  0,  1}, {  0,  0}},
-        {{ -0.7,   1,  0,  1}, {  0,  1}},
-    };
-
-    // Scales and translates the background element to offscreen
-    shapeObject returnShape = createShape(vert);
-    returnShape.scale = glm::scale(returnShape.scale, glm::vec3(FG_SCALE, FG_SCALE, 0.0));
-    returnShape.trans = glm::translate(returnShape.trans, glm::vec3(2.5, FG_POS_Y, 0.0));
-    return returnShape;
-}
-
 /**
  * Creates the shape for the ground with repeating textures.
  * Takes in totalRepeats, refering to how many times the texture should loop
  * @param int totalRepeats
  * @return shapeObject
  */
+template <typename Config>
 shapeObject createGround(int totalRepeats) {
 
     std::vector<vert> vert = {
@@ -180,7 +160,8 @@ shapeObject createGround(int totalRepeats) {
 
     shapeObject returnShape = createShape(vert);
     // Moves shape to the correct spot on the screen
-    returnShape.trans = glm::translate(returnShape.trans, glm::vec3(0.0, GROUND_POS_Y, 0.0));
-    returnShape.scale = glm::scale(returnShape.scale, glm::vec3(GROUND_SCALE, GROUND_SCALE, 0.0));
+    returnShape.trans = glm::translate(returnShape.trans, glm::vec3(0.0, Config::GROUND_POS_Y, 0.0));
+    returnShape.scale = glm::scale(returnShape.scale, glm::vec3(Config::GROUND_SCALE, Config::GROUND_SCALE, 0.0));
+    returnShape.uvParallax = Config::GROUND_PARALLAX;
     return returnShape;
 }
\ No newline at end of file
@@ -1,5 +1,5 @@
 /**
- * File contains shapeObject struct, which contains the VAO, VBO, TexID etc. for any
+ * File contains shapeObject struct, which contains the VAO, TexID etc. for any
  * individual shape.
  */
 
@@ -12,17 +12,23 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
+#include <algorithm>
+
 
 /**
- * Contains all the vertex attribute/buffer objects and the textureID
- * of an individual shape
+ * Contains the vertex array and the textureID of an individual shape. The vertex array
+ * belongs to meshRegistry and is shared with every shape that has the same vertices
  */
 struct shapeObject {
 
-    GLuint vao;
-    GLuint vbo;
+    GLuint vao = 0;
+    GLsizei vertexCount = 0;
     GLuint textureID;
-    std::vector<vert> vertices;
+    // How many texture repeats the shape scrolls per unit the scene scrolls. 0 if it does not scroll
+    float uvParallax = 0;
+    // Smallest and largest x/y of the vertices, before any transformations
+    glm::vec2 boundsMin = glm::vec2(-1.0f, -1.0f);
+    glm::vec2 boundsMax = glm::vec2(1.0f, 1.0f);
 
     glm::mat4 trans = glm::mat4(1.0f);
     glm::mat4 rot = glm::mat4(1.0f);
@@ -38,11 +44,33 @@ struct shapeObject {
     }
 
     /**
-     * Deletes this shape and the related VBO and VAO
+     * Checks whether any of the shape lands on the screen once transformed
+     * @param model the shape's trans * rot * scale
+     */
+    bool isOnScreen(const glm::mat4 &model) const {
+        const glm::vec4 corners[4] = {
+            model * glm::vec4(boundsMin.x, boundsMin.y, 0.0f, 1.0f),
+            model * glm::vec4(boundsMax.x, boundsMin.y, 0.0f, 1.0f),
+            model * glm::vec4(boundsMin.x, boundsMax.y, 0.0f, 1.0f),
+            model * glm::vec4(boundsMax.x, boundsMax.y, 0.0f, 1.0f),
+        };
+        float minX = corners[0].x, maxX = corners[0].x, minY = corners[0].y, maxY = corners[0].y;
+        for (const glm::vec4 &corner : corners) {
+            minX = std::min(minX, corner.x);
+            maxX = std::max(maxX, corner.x);
+            minY = std::min(minY, corner.y);
+            maxY = std::max(maxY, corner.y);
+        }
+        // The scene is drawn straight into clip space, which spans -1 to 1
+        return maxX >= -1 && minX <= 1 && maxY >= -1 && minY <= 1;
+    }
+
+    /**
+     * Deletes this shape. Its mesh is deleted once no other shape uses it
      */
     void deleteSelf() {
-        vertices.clear();
-        glDeleteBuffers(1, &vbo);
-        glDeleteVertexArrays(1, &vao);
+        meshes.release(vao);
+        vao = 0;
+        vertexCount = 0;
     }
 };
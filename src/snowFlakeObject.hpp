@@ -11,23 +11,37 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
-// Required external variables
-extern const float FLAKE_ROT_SPEED;
-
 /**
  * Contains all things related to an individual snowflake
  */
+template <typename Config>
 struct snowFlakeObject {
     shapeObject snowFlakeShape;
     bool isActive = true;
+    // How many ticks the flake lives for once it is active, counted down by the scene's
+    // timers. 0 once it has run out, and the flake respawns
     int flakeLifeTime = 0;
     // True for anti-clockwise
     // False for clockwise
-    bool rotDirection = (rand() % 2 == 0);
+    bool rotDirection = (rdmInt() % 2 == 0);
     // Random rotational speed added onto the base speed
-    float rotSpeed = FLAKE_ROT_SPEED + abs(rdmNumGen());
+    float rotSpeed = Config::FLAKE_ROT_SPEED + abs(rdmNumGen());
     // Random gravity multiplier (controls how fast the flake falls)
     float velMultiplier = 0.1 + abs(rdmNumGen());
     // Controls how fast the snowflake scrolls to the left
     float velX = -0.01 * (abs(rdmNumGen()));
+
+    /**
+     * Saves or restores this snowflake through a stateStream
+     */
+    template <typename Stream>
+    void transferState(Stream &stream) {
+        stream.shape(snowFlakeShape);
+        stream.field(isActive);
+        stream.field(flakeLifeTime);
+        stream.field(rotDirection);
+        stream.field(rotSpeed);
+        stream.field(velMultiplier);
+        stream.field(velX);
+    }
 };
\ No newline at end of file
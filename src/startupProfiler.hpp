@@ -0,0 +1,185 @@
+/**
+ * File contains startupProfiler, which records how long each stage of starting up takes
+ * and how long each asset takes to decode and upload. Once the first frame is shown it
+ * can print the stages and the slowest assets, and write everything as a trace that
+ * chrome://tracing or ui.perfetto.dev can open. Does not depend on OpenGL
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * What a recorded stretch of time was spent on
+ */
+enum startupPhase {
+    STARTUP_STAGE,   // A step of main, which may contain assets
+    STARTUP_DECODE,  // Reading an asset from disk and decoding it
+    STARTUP_UPLOAD,  // Copying an asset to the GPU
+    STARTUP_PHASES
+};
+
+const char *STARTUP_PHASE_NAMES[STARTUP_PHASES] = {"stage", "decode", "upload"};
+
+/**
+ * A recorded stretch of time. Times are in milliseconds since the program started
+ */
+struct startupEvent {
+    std::string name;
+    startupPhase phase;
+    double startMs;
+    double durationMs;
+    long long fileBytes;  // Size of the asset's file, -1 if it is not a file
+    int thread;           // 0 for the thread that started recording, then in order of first event
+};
+
+/**
+ * Collects the events of starting up. Any thread can record until finish is called,
+ * after which recording costs nothing
+ */
+struct startupProfiler {
+private:
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    std::atomic<bool> recording{true};
+    std::mutex eventsLock;
+    std::vector<startupEvent> events;
+    std::vector<std::thread::id> threads{std::this_thread::get_id()};
+    double finishMs = 0;
+
+public:
+    bool isRecording() const {
+        return recording.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Milliseconds since the program started
+     */
+    double nowMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    /**
+     * Records something that started at startMs and has just finished
+     * @param fileBytes size of the file the loader read for the asset, -1 if it is not a file
+     */
+    void record(const std::string &name, startupPhase phase, double startMs, long long fileBytes = -1) {
+        if (!isRecording()) return;
+        double endMs = nowMs();
+
+        std::lock_guard<std::mutex> guard(eventsLock);
+        int thread = std::find(threads.begin(), threads.end(), std::this_thread::get_id()) - threads.begin();
+        if (thread == (int)threads.size()) threads.push_back(std::this_thread::get_id());
+        events.push_back({name, phase, startMs, endMs - startMs, fileBytes, thread});
+    }
+
+    /**
+     * Stops recording. Called once the first frame has been shown
+     */
+    void finish() {
+        std::lock_guard<std::mutex> guard(eventsLock);
+        if (!isRecording()) return;
+        finishMs = nowMs();
+        recording = false;
+    }
+
+    /**
+     * Prints every stage in the order they started, then the assets that took longest
+     * @param slowestAssets how many assets to list
+     */
+    void printTimeline(size_t slowestAssets) {
+        std::lock_guard<std::mutex> guard(eventsLock);
+        std::vector<startupEvent> sorted = events;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const startupEvent &a, const startupEvent &b) {
+            return a.startMs < b.startMs;
+        });
+
+        std::cout << "  Took " << std::fixed << std::setprecision(1) << finishMs << " ms in total\n";
+        double assetMs[STARTUP_PHASES] = {};
+        long long assetBytes = 0;
+        for (const startupEvent &event : sorted) {
+            if (event.phase == STARTUP_STAGE) {
+                std::cout << "  " << std::fixed << std::setprecision(1) << std::setw(8) << event.startMs << " ms +"
+                          << std::setw(7) << event.durationMs << " ms  " << event.name << "\n";
+            } else {
+                assetMs[event.phase] += event.durationMs;
+                if (event.fileBytes > 0) assetBytes += event.fileBytes;
+            }
+        }
+        std::cout << "  Assets: " << assetMs[STARTUP_DECODE] << " ms decoding " << assetBytes / 1024 << " KiB of files, "
+                  << assetMs[STARTUP_UPLOAD] << " ms uploading\n";
+
+        // Adds the decode and upload of each asset together
+        std::vector<startupEvent> assets;
+        for (const startupEvent &event : sorted) {
+            if (event.phase == STARTUP_STAGE) continue;
+            auto same = std::find_if(assets.begin(), assets.end(), [&](const startupEvent &asset) { return asset.name == event.name; });
+            if (same == assets.end()) {
+                assets.push_back(event);
+            } else {
+                same->durationMs += event.durationMs;
+                same->fileBytes = std::max(same->fileBytes, event.fileBytes);
+            }
+        }
+        std::sort(assets.begin(), assets.end(), [](const startupEvent &a, const startupEvent &b) {
+            return a.durationMs > b.durationMs;
+        });
+        std::cout << "  Slowest assets:\n";
+        for (size_t i = 0; i < std::min(slowestAssets, assets.size()); i++) {
+            std::cout << "  " << std::setw(8) << assets[i].durationMs << " ms  " << std::setw(6)
+                      << (assets[i].fileBytes >= 0 ? assets[i].fileBytes / 1024 : 0) << " KiB  " << assets[i].name << "\n";
+        }
+        std::cout << std::defaultfloat;
+    }
+
+    /**
+     * Writes every event in the Trace Event Format
+     * @return bool whether the file was written
+     */
+    bool writeTrace(const std::string &fileName) {
+        std::lock_guard<std::mutex> guard(eventsLock);
+        std::ofstream file(fileName);
+        if (!file) return false;
+        file << "{\"traceEvents\": [\n";
+        for (size_t i = 0; i < events.size(); i++) {
+            const startupEvent &event = events[i];
+            file << "  {\"name\": \"";
+            for (char c : event.name) {
+                if (c == '"' || c == '\\') file << '\\';
+                file << c;
+            }
+            // Times are in microseconds
+            file << "\", \"cat\": \"" << STARTUP_PHASE_NAMES[event.phase] << "\", \"ph\": \"X\", \"ts\": "
+                 << (long long)(event.startMs * 1000) << ", \"dur\": " << (long long)(event.durationMs * 1000)
+                 << ", \"pid\": 1, \"tid\": " << event.thread;
+            if (event.fileBytes >= 0) file << ", \"args\": {\"bytes\": " << event.fileBytes << "}";
+            file << "}" << ((i + 1 < events.size()) ? ",\n" : "\n");
+        }
+        file << "]}\n";
+        return (bool)file;
+    }
+};
+
+// Everything recorded while the program starts up
+startupProfiler startupProfile;
+
+/**
+ * Times consecutive stretches of work. Each lap records the time since the last one
+ */
+struct startupTimer {
+    double lapStart = startupProfile.nowMs();
+
+    /**
+     * @param fileBytes size of the file the loader read for the asset, -1 if it is not a file
+     */
+    void lap(const std::string &name, startupPhase phase, long long fileBytes = -1) {
+        startupProfile.record(name, phase, lapStart, fileBytes);
+        lapStart = startupProfile.nowMs();
+    }
+};
@@ -0,0 +1,303 @@
+/**
+ * File contains textureResidency, which only keeps the textures that are in use or were
+ * used recently on the GPU. A texture is decoded on a separate thread as soon as it is
+ * asked for and uploaded by the render loop. Once the textures on the GPU take up more
+ * than a budget, the ones that were used the longest time ago are evicted (LRU)
+ */
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <chicken3421/chicken3421.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Where a texture is between being asked for and being on the GPU
+ */
+enum residencyState {
+    TEX_EVICTED,   // Only a transparent pixel is on the GPU
+    TEX_DECODING,  // Waiting for or being decoded by the decoding thread
+    TEX_DECODED,   // Decoded, waiting for the render loop to upload it
+    TEX_RESIDENT   // On the GPU
+};
+
+/**
+ * A texture the residency manager looks after. Its texture name stays the same while it
+ * is evicted, so shapes can keep hold of it
+ */
+struct residentTexture {
+    std::string fileName;
+    GLuint texture = 0;
+    GLuint palette = 0;
+    residencyState state = TEX_EVICTED;
+    int users = 0;        // How many shapes are showing the texture. Never evicted while above 0
+    long lastUsed = 0;    // When the texture was last given to or taken off a shape
+    long long bytes = 0;  // GPU memory taken up while resident
+    // Set once the texture has been decoded. Read by the simulation without locking
+    std::atomic<textureAlpha> alpha{ALPHA_BLENDED};
+
+    // Pixels from the decoding thread. indexed is used if paletted, otherwise rgba
+    bool paletted = false;
+    palettisedImage indexed;
+    std::vector<unsigned char> rgba;
+    int width = 0, height = 0;
+};
+
+/**
+ * Decodes an image the same way makeTexture does, without touching OpenGL or the lists
+ * of everything made, so it can be run on any thread
+ */
+void decodeTexture(residentTexture &entry) {
+    startupTimer timer;
+    entry.rgba.clear();
+    entry.paletted = appConfig::PALETTE_TEXTURES && readCurrentPalettisedImage(entry.fileName, entry.indexed);
+    long long fileBytes = entry.indexed.fileBytes;
+    if (!entry.paletted) {
+        chicken3421::image_t texImg = loadImage(entry.fileName, fileBytes);
+        const unsigned char *pixels = (const unsigned char *)texImg.data;
+        entry.paletted = appConfig::PALETTE_TEXTURES && palettiseImage(pixels, texImg.width, texImg.height, texImg.n_channels, entry.indexed);
+        if (!entry.paletted) {
+            entry.width = texImg.width;
+            entry.height = texImg.height;
+            entry.rgba.resize((size_t)texImg.width * texImg.height * 4);
+            for (size_t pixel = 0; pixel < (size_t)texImg.width * texImg.height; pixel++) {
+                const unsigned char *source = pixels + pixel * texImg.n_channels;
+                unsigned char *dest = entry.rgba.data() + pixel * 4;
+                dest[0] = source[0];
+                dest[1] = source[1];
+                dest[2] = source[2];
+                dest[3] = (texImg.n_channels == 4) ? source[3] : 255;
+            }
+            entry.alpha = alphaOfPixels(entry.rgba.data(), (size_t)texImg.width * texImg.height, 4);
+        }
+        chicken3421::delete_image(texImg);
+    }
+    if (entry.paletted) {
+        entry.width = entry.indexed.width;
+        entry.height = entry.indexed.height;
+        entry.alpha = alphaOfIndexed(entry.indexed);
+    }
+    timer.lap(entry.fileName, STARTUP_DECODE, fileBytes);
+}
+
+/**
+ * Keeps a set of textures on the GPU within a memory budget. The simulation says which
+ * textures shapes are showing, the render loop uploads and evicts them
+ */
+template <typename Config>
+struct textureResidency {
+private:
+    // Never added to once the simulation has started, so it can be read without locking
+    std::deque<residentTexture> entries;
+    std::unordered_map<GLuint, int> entryOfTexture;
+    memSubsystem subsystem = MEM_SCENERY_TEXTURES;
+
+    // Guards everything in the entries apart from their file name, texture names and alpha
+    std::mutex entriesLock;
+    std::condition_variable decodeWanted, decodeFinished;
+    std::deque<int> decodeQueue;
+    std::thread decoder;
+    bool stopping = false;
+    long useCount = 0;
+    long long residentBytes = 0;
+
+public:
+    textureResidency() {
+        decoder = std::thread([this] { decodeLoop(); });
+    }
+
+    ~textureResidency() {
+        {
+            std::lock_guard<std::mutex> guard(entriesLock);
+            stopping = true;
+        }
+        decodeWanted.notify_all();
+        decoder.join();
+    }
+
+    /**
+     * Adds an image to the textures being looked after. Nothing is loaded until a shape
+     * uses it. Must be called before the simulation starts
+     * @param memSubsystem what the texture's memory is counted against
+     * @return GLuint texture handler, which shows nothing until the texture is resident
+     */
+    GLuint add(const std::string &fileName, memSubsystem textureSubsystem) {
+        subsystem = textureSubsystem;
+        residentTexture &entry = entries.emplace_back();
+        entry.fileName = fileName;
+        entry.texture = uploadTexture(GL_RGBA8, GL_RGBA, 1, 1, TRANSPARENT_PIXEL);
+        entry.palette = uploadTexture(GL_RGBA8, GL_RGBA, 1, 1, TRANSPARENT_PIXEL);
+        entryOfTexture[entry.texture] = entries.size() - 1;
+        return entry.texture;
+    }
+
+    /**
+     * Marks a texture as shown by one more shape, and starts decoding it if it is not on
+     * the GPU. Called as soon as a shape is given the texture, while it is still off screen.
+     * Textures that are not looked after are ignored
+     */
+    void use(GLuint tex) {
+        auto found = entryOfTexture.find(tex);
+        if (found == entryOfTexture.end()) return;
+        std::lock_guard<std::mutex> guard(entriesLock);
+        residentTexture &entry = entries[found->second];
+        entry.users++;
+        entry.lastUsed = ++useCount;
+        if (entry.state == TEX_EVICTED) {
+            entry.state = TEX_DECODING;
+            decodeQueue.push_back(found->second);
+            decodeWanted.notify_one();
+        }
+    }
+
+    /**
+     * Marks a texture as shown by one less shape. It stays on the GPU until it is evicted
+     */
+    void release(GLuint tex) {
+        auto found = entryOfTexture.find(tex);
+        if (found == entryOfTexture.end()) return;
+        std::lock_guard<std::mutex> guard(entriesLock);
+        residentTexture &entry = entries[found->second];
+        if (entry.users > 0) entry.users--;
+        entry.lastUsed = ++useCount;
+    }
+
+    /**
+     * Marks every texture as not shown by any shape
+     */
+    void releaseAll() {
+        std::lock_guard<std::mutex> guard(entriesLock);
+        for (residentTexture &entry : entries) {
+            entry.users = 0;
+        }
+    }
+
+    /**
+     * How much of a texture can be seen through, for textures that are looked after or not
+     * @return textureAlpha
+     */
+    textureAlpha alphaOf(GLuint tex) {
+        auto found = entryOfTexture.find(tex);
+        if (found == entryOfTexture.end()) return ::alphaOf(tex);
+        return entries[found->second].alpha;
+    }
+
+    /**
+     * Uploads the textures that have been decoded, then evicts the textures used the
+     * longest time ago that are not being shown until the budget is met. Called by the
+     * render loop before drawing
+     */
+    void update() {
+        std::lock_guard<std::mutex> guard(entriesLock);
+        for (residentTexture &entry : entries) {
+            if (entry.state == TEX_DECODED) upload(entry);
+        }
+
+        while (residentBytes > Config::SCENERY_TEX_BUDGET) {
+            residentTexture *oldest = nullptr;
+            for (residentTexture &entry : entries) {
+                if (entry.state != TEX_RESIDENT || entry.users > 0) continue;
+                if (oldest == nullptr || entry.lastUsed < oldest->lastUsed) oldest = &entry;
+            }
+            // Everything left is being shown
+            if (oldest == nullptr) break;
+            evict(*oldest);
+        }
+    }
+
+    /**
+     * Waits for every texture that has been asked for to be decoded and uploads them.
+     * Used before the first frame so it does not show the scenery missing
+     */
+    void finishDecoding() {
+        {
+            std::unique_lock<std::mutex> guard(entriesLock);
+            decodeFinished.wait(guard, [&] {
+                for (residentTexture &entry : entries) {
+                    if (entry.state == TEX_DECODING) return false;
+                }
+                return true;
+            });
+        }
+        update();
+    }
+
+private:
+    static constexpr unsigned char TRANSPARENT_PIXEL[4] = {0, 0, 0, 0};
+
+    /**
+     * Decodes textures as they are asked for until the manager is destroyed
+     */
+    void decodeLoop() {
+        std::unique_lock<std::mutex> guard(entriesLock);
+        while (true) {
+            decodeWanted.wait(guard, [&] { return stopping || !decodeQueue.empty(); });
+            if (stopping) return;
+            residentTexture &entry = entries[decodeQueue.front()];
+            decodeQueue.pop_front();
+
+            // Only this thread touches the pixels of an entry that is decoding
+            guard.unlock();
+            decodeTexture(entry);
+            guard.lock();
+
+            entry.state = TEX_DECODED;
+            decodeFinished.notify_all();
+        }
+    }
+
+    /**
+     * Moves a decoded texture onto the GPU and frees its pixels
+     */
+    void upload(residentTexture &entry) {
+        startupTimer timer;
+        if (entry.paletted) {
+            unsigned char fullPalette[MAX_PALETTE_SIZE * 4] = {};
+            memcpy(fullPalette, entry.indexed.palette.data(), entry.indexed.paletteSize * 4);
+            fillTexture(entry.texture, GL_R8, GL_RED, entry.width, entry.height, entry.indexed.indices.data());
+            fillTexture(entry.palette, GL_RGBA8, GL_RGBA, MAX_PALETTE_SIZE, 1, fullPalette);
+            paletteOfTexture[entry.texture] = entry.palette;
+            memTracker.trackTexture(entry.texture, subsystem, entry.width, entry.height, 1);
+            memTracker.trackTexture(entry.palette, subsystem, MAX_PALETTE_SIZE, 1, 4);
+            entry.bytes = (long long)entry.width * entry.height + MAX_PALETTE_SIZE * 4;
+        } else {
+            fillTexture(entry.texture, GL_RGBA8, GL_RGBA, entry.width, entry.height, entry.rgba.data());
+            memTracker.trackTexture(entry.texture, subsystem, entry.width, entry.height, 4);
+            entry.bytes = (long long)entry.width * entry.height * 4;
+        }
+        entry.indexed = palettisedImage();
+        entry.rgba = std::vector<unsigned char>();
+        entry.state = TEX_RESIDENT;
+        residentBytes += entry.bytes;
+        timer.lap(entry.fileName, STARTUP_UPLOAD);
+    }
+
+    /**
+     * Frees the GPU memory of a texture, leaving a transparent pixel in its place
+     */
+    void evict(residentTexture &entry) {
+        printMessageTime();
+        std::cout << "Evicted texture " << entry.fileName << "\n";
+        fillTexture(entry.texture, GL_RGBA8, GL_RGBA, 1, 1, TRANSPARENT_PIXEL);
+        fillTexture(entry.palette, GL_RGBA8, GL_RGBA, 1, 1, TRANSPARENT_PIXEL);
+        paletteOfTexture.erase(entry.texture);
+        memTracker.untrackTexture(entry.texture);
+        memTracker.untrackTexture(entry.palette);
+        entry.state = TEX_EVICTED;
+        residentBytes -= entry.bytes;
+        entry.bytes = 0;
+    }
+};
@@ -0,0 +1,145 @@
+/**
+ * File contains timerWheel, which keeps countdowns as the tick they run out on instead of
+ * counting each of them down every tick. Timers that run out soon sit in one slot per
+ * tick, later ones in a slot per 256 ticks that is spread into the per tick slots when
+ * it comes up (a hierarchical timer wheel). Moving on a tick only looks at the timers
+ * that run out on it
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+/**
+ * A fixed set of timers, numbered 0 to TIMERS - 1. Each timer is either not set or runs
+ * out on one tick. Never allocates
+ */
+template <int TIMERS>
+struct timerWheel {
+private:
+    static constexpr int NEAR_BITS = 8;
+    static constexpr int NEAR_SLOTS = 1 << NEAR_BITS;                 // One slot per tick
+    static constexpr int FAR_SLOTS = 64;                              // One slot per NEAR_SLOTS ticks
+    static constexpr int OVERFLOW_SLOT = NEAR_SLOTS + FAR_SLOTS;      // Anything further away
+    static constexpr int NONE = -1;
+
+    /**
+     * A timer, linked into the list of the slot it is waiting in
+     */
+    struct timerNode {
+        uint32_t expiry = 0;
+        int slot = NONE;
+        int prev = NONE;
+        int next = NONE;
+    };
+
+    std::array<timerNode, TIMERS> nodes;
+    std::array<int, OVERFLOW_SLOT + 1> heads;
+    uint32_t now = 0;
+
+public:
+    timerWheel() {
+        heads.fill(NONE);
+    }
+
+    bool isScheduled(int timer) const {
+        return nodes[timer].slot != NONE;
+    }
+
+    /**
+     * Sets a timer to run out the given number of ticks from now, replacing it if it
+     * was already set
+     */
+    void schedule(int timer, uint32_t ticks) {
+        cancel(timer);
+        nodes[timer].expiry = now + std::max<uint32_t>(ticks, 1);
+        link(timer);
+    }
+
+    void cancel(int timer) {
+        if (isScheduled(timer)) unlink(timer);
+    }
+
+    /**
+     * Moves on one tick and calls onExpire(timer) for every timer that runs out on it.
+     * onExpire may set timers again
+     */
+    template <typename Callback>
+    void advance(Callback onExpire) {
+        now++;
+        if ((now & (NEAR_SLOTS - 1)) == 0) {
+            // Moves the next block of timers into the per tick slots
+            uint32_t block = now >> NEAR_BITS;
+            if (block % FAR_SLOTS == 0) relinkSlot(OVERFLOW_SLOT);
+            relinkSlot(NEAR_SLOTS + block % FAR_SLOTS);
+        }
+
+        int slot = now & (NEAR_SLOTS - 1);
+        while (heads[slot] != NONE) {
+            int timer = heads[slot];
+            unlink(timer);
+            onExpire(timer);
+        }
+    }
+
+    /**
+     * Saves or restores the current tick and every timer through a stateStream
+     */
+    template <typename Stream>
+    void transferState(Stream &stream) {
+        stream.field(now);
+        for (int timer = 0; timer < TIMERS; timer++) {
+            // 0 for a timer that is not set, as no timer can run out on the first tick
+            uint32_t expiry = isScheduled(timer) ? nodes[timer].expiry : 0;
+            stream.field(expiry);
+            if (stream.isLoading()) {
+                cancel(timer);
+                if (expiry != 0) {
+                    nodes[timer].expiry = expiry;
+                    link(timer);
+                }
+            }
+        }
+    }
+
+private:
+    /**
+     * Works out which slot a timer waits in from how far away it runs out
+     */
+    int slotFor(uint32_t expiry) {
+        uint32_t expiryBlock = expiry >> NEAR_BITS, nowBlock = now >> NEAR_BITS;
+        if (expiryBlock == nowBlock) return expiry & (NEAR_SLOTS - 1);
+        if (expiryBlock - nowBlock < FAR_SLOTS) return NEAR_SLOTS + expiryBlock % FAR_SLOTS;
+        return OVERFLOW_SLOT;
+    }
+
+    void link(int timer) {
+        timerNode &node = nodes[timer];
+        node.slot = slotFor(node.expiry);
+        node.prev = NONE;
+        node.next = heads[node.slot];
+        if (node.next != NONE) nodes[node.next].prev = timer;
+        heads[node.slot] = timer;
+    }
+
+    void unlink(int timer) {
+        timerNode &node = nodes[timer];
+        if (node.prev != NONE) nodes[node.prev].next = node.next;
+        else heads[node.slot] = node.next;
+        if (node.next != NONE) nodes[node.next].prev = node.prev;
+        node.slot = NONE;
+    }
+
+    /**
+     * Puts every timer in a slot back into the slot it now belongs in
+     */
+    void relinkSlot(int slot) {
+        int timer = heads[slot];
+        heads[slot] = NONE;
+        while (timer != NONE) {
+            int next = nodes[timer].next;
+            link(timer);
+            timer = next;
+        }
+    }
+};